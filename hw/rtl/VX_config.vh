@@ -647,6 +647,24 @@
     `define EXT_ZICOND_ENABLED 0
 `endif
 
+`ifdef EXT_ZBA_ENABLE
+    `define EXT_ZBA_ENABLED 1
+`else
+    `define EXT_ZBA_ENABLED 0
+`endif
+
+`ifdef EXT_ZBB_ENABLE
+    `define EXT_ZBB_ENABLED 1
+`else
+    `define EXT_ZBB_ENABLED 0
+`endif
+
+`ifdef EXT_ZBS_ENABLE
+    `define EXT_ZBS_ENABLED 1
+`else
+    `define EXT_ZBS_ENABLED 0
+`endif
+
 `define ISA_STD_A           0
 `define ISA_STD_C           2
 `define ISA_STD_D           3
@@ -665,13 +683,19 @@
 `define ISA_EXT_L3CACHE     3
 `define ISA_EXT_LMEM        4
 `define ISA_EXT_ZICOND      5
+`define ISA_EXT_ZBA         6
+`define ISA_EXT_ZBB         7
+`define ISA_EXT_ZBS         8
 
 `define MISA_EXT  (`ICACHE_ENABLED  << `ISA_EXT_ICACHE) \
                 | (`DCACHE_ENABLED  << `ISA_EXT_DCACHE) \
                 | (`L2_ENABLED      << `ISA_EXT_L2CACHE) \
                 | (`L3_ENABLED      << `ISA_EXT_L3CACHE) \
                 | (`LMEM_ENABLED    << `ISA_EXT_LMEM) \
-                | (`EXT_ZICOND_ENABLED << `ISA_EXT_ZICOND)
+                | (`EXT_ZICOND_ENABLED << `ISA_EXT_ZICOND) \
+                | (`EXT_ZBA_ENABLED << `ISA_EXT_ZBA) \
+                | (`EXT_ZBB_ENABLED << `ISA_EXT_ZBB) \
+                | (`EXT_ZBS_ENABLED << `ISA_EXT_ZBS)
 
 `define MISA_STD  (`EXT_A_ENABLED <<  0) /* A - Atomic Instructions extension */ \
                 | (0 <<  1) /* B - Tentatively reserved for Bit operations extension */ \
@@ -59,6 +59,8 @@
 
 `define VX_CSR_MNSTATUS                 12'h744
 
+`define VX_CSR_SIM_REGION               12'h7C0     // simulation region marker
+
 `define VX_CSR_MPM_BASE                 12'hB00
 `define VX_CSR_MPM_BASE_H               12'hB80
 `define VX_CSR_MPM_USER                 12'hB03
@@ -171,9 +173,15 @@
 `define VX_CSR_MPM_LMEM_WRITES_H        12'hB9C
 `define VX_CSR_MPM_LMEM_BANK_ST         12'hB1D     // bank conflicts
 `define VX_CSR_MPM_LMEM_BANK_ST_H       12'hB9D
+// PERF: atomics
+`define VX_CSR_MPM_AMOS                 12'hB1E     // near-memory atomics
+`define VX_CSR_MPM_AMOS_H               12'hB9E
+`define VX_CSR_MPM_AMO_ST               12'hB1F     // atomic unit stalls
+`define VX_CSR_MPM_AMO_ST_H             12'hB9F
 
 // Machine Performance-monitoring memory counters (class 3) ///////////////////
 // <Add your own counters: use addresses hB03..B1F, hB83..hB9F>
+// <class 2 is full, hB1E/hB1F hold the atomics counters: add new memory counters here>
 
 // Machine Information Registers //////////////////////////////////////////////
 
@@ -140,7 +140,8 @@ import VX_fpu_pkg::*;
                 `VX_CSR_MTVEC,
                 `VX_CSR_MEPC,
                 `VX_CSR_PMPCFG0,
-                `VX_CSR_PMPADDR0: begin
+                `VX_CSR_PMPADDR0,
+                `VX_CSR_SIM_REGION: begin
                     // do nothing!
                 end
                 `VX_CSR_MSCRATCH: begin
@@ -200,7 +201,8 @@ import VX_fpu_pkg::*;
             `VX_CSR_MTVEC,
             `VX_CSR_MEPC,
             `VX_CSR_PMPCFG0,
-            `VX_CSR_PMPADDR0 : read_data_ro_r = `XLEN'(0);
+            `VX_CSR_PMPADDR0,
+            `VX_CSR_SIM_REGION : read_data_ro_r = `XLEN'(0);
 
             default: begin
                 read_addr_valid_r = 0;
@@ -159,6 +159,135 @@ inline void vx_barrier(int barried_id, int num_warps) {
     asm volatile (".insn r %0, 4, 0, x0, %1, %2" :: "i"(RISCV_CUSTOM0), "r"(barried_id), "r"(num_warps));
 }
 
+// Warp shuffle: read value from thread src_lane
+// inactive or out-of-range source threads return the caller's own value
+inline int vx_shfl_idx(int value, int src_lane) {
+    int ret;
+    asm volatile (".insn r %1, 0, 0, %0, %2, %3" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(value), "r"(src_lane));
+    return ret;
+}
+
+// Warp shuffle: read value from thread (tid - delta)
+inline int vx_shfl_up(int value, int delta) {
+    int ret;
+    asm volatile (".insn r %1, 0, 1, %0, %2, %3" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(value), "r"(delta));
+    return ret;
+}
+
+// Warp shuffle: read value from thread (tid + delta)
+inline int vx_shfl_down(int value, int delta) {
+    int ret;
+    asm volatile (".insn r %1, 0, 2, %0, %2, %3" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(value), "r"(delta));
+    return ret;
+}
+
+// Warp shuffle: read value from thread (tid ^ lane_mask)
+inline int vx_shfl_xor(int value, int lane_mask) {
+    int ret;
+    asm volatile (".insn r %1, 0, 3, %0, %2, %3" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(value), "r"(lane_mask));
+    return ret;
+}
+
+// Warp vote: non-zero if the predicate is set in any active thread
+inline int vx_vote_any(int predicate) {
+    int ret;
+    asm volatile (".insn r %1, 1, 0, %0, %2, x0" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(predicate));
+    return ret;
+}
+
+// Warp vote: non-zero if the predicate is set in all active threads
+inline int vx_vote_all(int predicate) {
+    int ret;
+    asm volatile (".insn r %1, 1, 1, %0, %2, x0" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(predicate));
+    return ret;
+}
+
+// Warp vote: mask of the active threads with the predicate set
+inline size_t vx_vote_ballot(int predicate) {
+    size_t ret;
+    asm volatile (".insn r %1, 1, 2, %0, %2, x0" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(predicate));
+    return ret;
+}
+
+// Warp reduction: sum of value across the active threads
+inline int vx_reduce_add(int value) {
+    int ret;
+    asm volatile (".insn r %1, 2, 0, %0, %2, x0" : "=r"(ret) : "i"(RISCV_CUSTOM2), "r"(value));
+    return ret;
+}
+
+// Bit manipulation (Zba/Zbb/Zbs), usable without toolchain support for the extensions
+
+// (a << 1) + b
+inline size_t vx_sh1add(size_t a, size_t b) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 2, 0x10, %0, %1, %2" : "=r"(ret) : "r"(a), "r"(b));
+    return ret;
+}
+
+// (a << 2) + b
+inline size_t vx_sh2add(size_t a, size_t b) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 4, 0x10, %0, %1, %2" : "=r"(ret) : "r"(a), "r"(b));
+    return ret;
+}
+
+// (a << 3) + b
+inline size_t vx_sh3add(size_t a, size_t b) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 6, 0x10, %0, %1, %2" : "=r"(ret) : "r"(a), "r"(b));
+    return ret;
+}
+
+// a & ~b
+inline size_t vx_andn(size_t a, size_t b) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 7, 0x20, %0, %1, %2" : "=r"(ret) : "r"(a), "r"(b));
+    return ret;
+}
+
+// Count leading zeros
+inline size_t vx_clz(size_t value) {
+    size_t ret;
+    asm volatile (".insn i 0x13, 1, %0, %1, 0x600" : "=r"(ret) : "r"(value));
+    return ret;
+}
+
+// Count trailing zeros
+inline size_t vx_ctz(size_t value) {
+    size_t ret;
+    asm volatile (".insn i 0x13, 1, %0, %1, 0x601" : "=r"(ret) : "r"(value));
+    return ret;
+}
+
+// Count set bits
+inline size_t vx_cpop(size_t value) {
+    size_t ret;
+    asm volatile (".insn i 0x13, 1, %0, %1, 0x602" : "=r"(ret) : "r"(value));
+    return ret;
+}
+
+// Set bit index
+inline size_t vx_bset(size_t value, size_t index) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 1, 0x14, %0, %1, %2" : "=r"(ret) : "r"(value), "r"(index));
+    return ret;
+}
+
+// Clear bit index
+inline size_t vx_bclr(size_t value, size_t index) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 1, 0x24, %0, %1, %2" : "=r"(ret) : "r"(value), "r"(index));
+    return ret;
+}
+
+// Extract bit index
+inline size_t vx_bext(size_t value, size_t index) {
+    size_t ret;
+    asm volatile (".insn r 0x33, 5, 0x24, %0, %1, %2" : "=r"(ret) : "r"(value), "r"(index));
+    return ret;
+}
+
 // Return current thread identifier
 inline int vx_thread_id() {
     int ret;
@@ -229,6 +358,11 @@ inline int vx_hart_id() {
     return ret;
 }
 
+// Mark the start (1) or end (0) of the detailed simulation region
+inline void vx_sim_region(int enable) {
+    asm volatile ("csrw %0, %1" :: "i"(VX_CSR_SIM_REGION), "r"(enable));
+}
+
 inline void vx_fence() {
     asm volatile ("fence iorw, iorw");
 }
@@ -0,0 +1,111 @@
+#!/bin/bash
+
+# exit when any command fails
+set -e
+
+LOG=./perf/simx/simx_perf.log
+PAR_LOG=./perf/simx/simx_parallel.log
+CORES=${CORES:-"1 4 16"}
+CLUSTERS=${CLUSTERS:-4}
+CLUSTER_CORES=${CLUSTER_CORES:-4}
+THREADS=${THREADS:-"1 2 4"}
+APP=${APP:-sgemm}
+ARGS=${ARGS:-"-n32"}
+# optional reference tree (e.g. a checkout of the previous release) to compare against
+REF=${REF:-""}
+
+# prints the cycles and the wall time in ms of one run from the given tree
+measure()
+{
+    local dir=$1
+    shift
+    cd $dir
+
+    # first run rebuilds the driver for this configuration
+    ./ci/blackbox.sh --driver=simx "$@" > /dev/null
+
+    local start=$(date +%s%N)
+    local perf=$(./ci/blackbox.sh --driver=simx "$@" --perf=1 | grep 'PERF: instrs=')
+    local end=$(date +%s%N)
+
+    echo "$(echo "$perf" | sed 's/.*cycles=\([0-9]*\),.*/\1/') $(( (end - start) / 1000000 ))"
+}
+
+throughput()
+{
+echo "begin simx throughput tests"
+
+rm -f $LOG
+for cores in $CORES
+do
+    read cycles ms <<< $(measure . --cores=$cores --app=$APP --args="$ARGS")
+    line="cores=$cores, cycles=$cycles, time=$ms ms, cycles/sec=$(( cycles * 1000 / ms ))"
+
+    if [ -n "$REF" ]
+    then
+        read ref_cycles ref_ms <<< $(measure $REF --cores=$cores --app=$APP --args="$ARGS")
+        speedup=$(awk "BEGIN { printf \"%.2f\", $ref_ms / $ms }")
+        line="$line, baseline: cycles=$ref_cycles, time=$ref_ms ms, cycles/sec=$(( ref_cycles * 1000 / ref_ms )), speedup=${speedup}x"
+    fi
+
+    echo "$line" | tee -a $LOG
+done
+
+echo "simx throughput tests done!"
+}
+
+parallel()
+{
+echo "begin simx parallel tests"
+
+rm -f $PAR_LOG
+
+# first run rebuilds the driver for this configuration
+./ci/blackbox.sh --driver=simx --clusters=$CLUSTERS --cores=$CLUSTER_CORES --app=$APP --args="$ARGS" > /dev/null
+
+base_ms=0
+base_perf=""
+for threads in $THREADS
+do
+    start=$(date +%s%N)
+    perf=$(VORTEX_SIMX_THREADS=$threads ./ci/blackbox.sh --driver=simx --clusters=$CLUSTERS --cores=$CLUSTER_CORES --app=$APP --args="$ARGS" --perf=1 | grep 'PERF: instrs=')
+    end=$(date +%s%N)
+
+    ms=$(( (end - start) / 1000000 ))
+    if [ $base_ms -eq 0 ]
+    then
+        base_ms=$ms
+        base_perf=$perf
+    fi
+
+    # every thread count must reproduce the serial run
+    if [ "$perf" != "$base_perf" ]
+    then
+        echo "threads=$threads: results differ from the serial run!"
+        exit 1
+    fi
+
+    cycles=$(echo "$perf" | sed 's/.*cycles=\([0-9]*\),.*/\1/')
+    speedup=$(awk "BEGIN { printf \"%.2f\", $base_ms / $ms }")
+    echo "clusters=$CLUSTERS, cores=$CLUSTER_CORES, threads=$threads, cycles=$cycles, time=$ms ms, speedup=${speedup}x" | tee -a $PAR_LOG
+done
+
+echo "simx parallel tests done!"
+}
+
+usage()
+{
+    echo "usage: [-t] [-p] [-h|--help]"
+    echo "set REF=<vortex tree> to also run the throughput tests from a reference build"
+}
+
+case $1 in
+    -t ) throughput
+            ;;
+    -p ) parallel
+            ;;
+    -h | --help ) usage
+                    ;;
+    * ) throughput
+        ;;
+esac
@@ -94,7 +94,9 @@ public:
         return 0;
     }
 
-    int allocate(uint64_t size, uint64_t* addr) {
+    // a non-zero alignment places the block at the start of a new page
+    // whose address is a multiple of it.
+    int allocate(uint64_t size, uint64_t* addr, uint64_t alignment = 0) {
         if (size == 0 || addr == nullptr) {
             printf("error: invalid arguments\n");
             return -1;
@@ -105,7 +107,7 @@ public:
 
         // Walk thru all pages to find a free block
         block_t* freeBlock = nullptr;
-        auto currPage = pages_;
+        auto currPage = (0 == alignment) ? pages_ : nullptr;
         while (currPage) {
             freeBlock = currPage->findFreeBlock(size);
             if (freeBlock != nullptr)
@@ -117,7 +119,7 @@ public:
         if (freeBlock == nullptr) {
             auto pageSize = alignSize(size, pageAlign_);
             uint64_t pageAddr;
-            if (!this->findNextAddress(pageSize, &pageAddr)) {
+            if (!this->findNextAddress(pageSize, &pageAddr, alignment ? alignment : 1)) {
                 printf("error: out of memory\n");
                 return -1;
             }
@@ -479,14 +481,14 @@ private:
         delete page;
     }
 
-    bool findNextAddress(uint64_t size, uint64_t* addr) {
+    bool findNextAddress(uint64_t size, uint64_t* addr, uint64_t alignment) {
         if (pages_ == nullptr) {
-            *addr = baseAddress_;
+            *addr = alignSize(baseAddress_, alignment);
             return  true;
         }
 
         page_t* current = pages_;
-        uint64_t endOfLastPage = baseAddress_;
+        uint64_t endOfLastPage = alignSize(baseAddress_, alignment);
 
         while (current != nullptr) {
             uint64_t startOfCurrentPage = current->addr;
@@ -496,7 +498,7 @@ private:
             }
             // Update the end of the last page to the end of the current page
             // Move to the next page in the sorted list
-            endOfLastPage = current->addr + current->size;
+            endOfLastPage = alignSize(current->addr + current->size, alignment);
             current = current->next;
         }
 
@@ -13,13 +13,17 @@
 
 #include "utils.h"
 #include <iostream>
-#include <fstream>
 #include <list>
 #include <cstring>
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 #include <vortex.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define RT_CHECK(_expr, _cleanup)                               \
   do {                                                         \
@@ -116,6 +120,53 @@ int DeviceConfig::read(uint32_t addr, uint32_t* value) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static std::list<const MappedFile*> gMappedFiles;
+static std::mutex gMappedFilesMutex;
+
+MappedFile::MappedFile(const char* filename)
+  : fd_(-1)
+  , data_(nullptr)
+  , size_(0) {
+  fd_ = open(filename, O_RDONLY);
+  if (fd_ < 0)
+    return;
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || 0 == st.st_size)
+    return;
+  auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED)
+    return;
+  data_ = (uint8_t*)data;
+  size_ = st.st_size;
+  std::lock_guard<std::mutex> lock(gMappedFilesMutex);
+  gMappedFiles.push_back(this);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    {
+      std::lock_guard<std::mutex> lock(gMappedFilesMutex);
+      gMappedFiles.remove(this);
+    }
+    munmap(data_, size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+const MappedFile* MappedFile::find(const void* ptr, uint64_t size) {
+  auto p = (const uint8_t*)ptr;
+  std::lock_guard<std::mutex> lock(gMappedFilesMutex);
+  for (auto file : gMappedFiles) {
+    if (p >= file->data_ && (p + size) <= (file->data_ + file->size_))
+      return file;
+  }
+  return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int dcr_initialize(vx_device_h hdevice) {
   const uint64_t startup_addr(STARTUP_ADDR);
 
@@ -192,21 +243,19 @@ extern int vx_upload_kernel_file(vx_device_h hdevice, const char* filename, vx_b
   if (nullptr == hdevice || nullptr == filename || nullptr == hbuffer)
     return -1;
 
-  std::ifstream ifs(filename);
-  if (!ifs) {
+  // map the file content, no intermediate copy
+  MappedFile file(filename);
+  if (file.fd() < 0) {
     std::cout << "error: " << filename << " not found" << std::endl;
     return -1;
   }
-
-  // read file content
-  ifs.seekg(0, ifs.end);
-  auto size = ifs.tellg();
-  std::vector<char> content(size);
-  ifs.seekg(0, ifs.beg);
-  ifs.read(content.data(), size);
+  if (!file.is_open()) {
+    std::cout << "error: " << filename << " could not be mapped" << std::endl;
+    return -1;
+  }
 
   // upload buffer
-  RT_CHECK(vx_upload_kernel_bytes(hdevice, content.data(), size, hbuffer), {
+  RT_CHECK(vx_upload_kernel_bytes(hdevice, file.data(), file.size(), hbuffer), {
     return _ret;
   });
 
@@ -237,21 +286,19 @@ extern int vx_upload_file(vx_device_h hdevice, const char* filename, vx_buffer_h
   if (nullptr == hdevice || nullptr == filename || nullptr == hbuffer)
     return -1;
 
-  std::ifstream ifs(filename);
-  if (!ifs) {
+  // map the file content, no intermediate copy
+  MappedFile file(filename);
+  if (file.fd() < 0) {
     std::cout << "error: " << filename << " not found" << std::endl;
     return -1;
   }
-
-  // read file content
-  ifs.seekg(0, ifs.end);
-  auto size = ifs.tellg();
-  std::vector<char> content(size);
-  ifs.seekg(0, ifs.beg);
-  ifs.read(content.data(), size);
+  if (!file.is_open()) {
+    std::cout << "error: " << filename << " could not be mapped" << std::endl;
+    return -1;
+  }
 
   // upload buffer
-  RT_CHECK(vx_upload_bytes(hdevice, content.data(), size, hbuffer), {
+  RT_CHECK(vx_upload_bytes(hdevice, file.data(), file.size(), hbuffer), {
     return _ret;
   });
 
@@ -319,6 +366,9 @@ extern int vx_dump_perf(vx_device_h hdevice, FILE* stream) {
   uint64_t mem_reads = 0;
   uint64_t mem_writes = 0;
   uint64_t mem_lat = 0;
+  // PERF: atomics
+  uint64_t amos = 0;
+  uint64_t amo_stalls = 0;
 #endif
 
   uint64_t num_cores;
@@ -645,6 +695,13 @@ extern int vx_dump_perf(vx_device_h hdevice, FILE* stream) {
         RT_CHECK(vx_mpm_query(hdevice, VX_CSR_MPM_MEM_LT, core_id, &mem_lat), {
           return _ret;
         });
+        // PERF: atomics
+        RT_CHECK(vx_mpm_query(hdevice, VX_CSR_MPM_AMOS, core_id, &amos), {
+          return _ret;
+        });
+        RT_CHECK(vx_mpm_query(hdevice, VX_CSR_MPM_AMO_ST, core_id, &amo_stalls), {
+          return _ret;
+        });
       }
     } break;
     default:
@@ -724,6 +781,9 @@ extern int vx_dump_perf(vx_device_h hdevice, FILE* stream) {
     int mem_avg_lat = caclAverage(mem_lat, mem_reads);
     fprintf(stream, "PERF: memory requests=%ld (reads=%ld, writes=%ld)\n", (mem_reads + mem_writes), mem_reads, mem_writes);
     fprintf(stream, "PERF: memory latency=%d cycles\n", mem_avg_lat);
+    if (amos != 0) {
+      fprintf(stream, "PERF: near-memory atomics=%ld (stalls=%ld)\n", amos, amo_stalls);
+    }
   } break;
   default:
     break;
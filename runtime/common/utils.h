@@ -27,6 +27,39 @@ private:
      std::unordered_map<uint32_t, uint32_t> store_;
 };
 
+// read-only mapping of a file's content, uploads from the mapped range
+// can be looked up to install the file pages directly in device memory.
+class MappedFile {
+public:
+    MappedFile(const char* filename);
+    ~MappedFile();
+
+    // the file exists and its content is mapped
+    bool is_open() const {
+        return data_ != nullptr;
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    const uint8_t* data() const {
+        return data_;
+    }
+
+    uint64_t size() const {
+        return size_;
+    }
+
+    // find the live mapping containing the host range
+    static const MappedFile* find(const void* ptr, uint64_t size);
+
+private:
+    int fd_;
+    uint8_t* data_;
+    uint64_t size_;
+};
+
 int dcr_initialize(vx_device_h device);
 
 uint64_t aligned_size(uint64_t size, uint64_t alignment);
@@ -55,6 +55,10 @@ typedef void* vx_buffer_h;
 #define VX_ISA_EXT_L2CACHE          (1ull << 34)
 #define VX_ISA_EXT_L3CACHE          (1ull << 35)
 #define VX_ISA_EXT_LMEM             (1ull << 36)
+#define VX_ISA_EXT_ZICOND           (1ull << 37)
+#define VX_ISA_EXT_ZBA              (1ull << 38)
+#define VX_ISA_EXT_ZBB              (1ull << 39)
+#define VX_ISA_EXT_ZBS              (1ull << 40)
 
 // ready wait timeout
 #define VX_MAX_TIMEOUT              (24*60*60*1000)   // 24 Hr
@@ -91,6 +95,12 @@ int vx_mem_address(vx_buffer_h hbuffer, uint64_t* address);
 // get device memory info
 int vx_mem_info(vx_device_h hdevice, uint64_t* mem_free, uint64_t* mem_used);
 
+// snapshot device memory content, pages are copied on their next write
+int vx_mem_snapshot(vx_device_h hdevice);
+
+// restore device memory content to the last snapshot
+int vx_mem_restore(vx_device_h hdevice);
+
 // Copy bytes from host to device memory
 int vx_copy_to_dev(vx_buffer_h hbuffer, const void* host_ptr, uint64_t dst_offset, uint64_t size);
 
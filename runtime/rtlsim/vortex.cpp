@@ -163,6 +163,24 @@ public:
         return 0;
     }
 
+    int mem_snapshot() {
+        if (future_.valid()) {
+            future_.wait(); // ensure prior run completed
+        }
+        ram_.snapshot();
+        return 0;
+    }
+
+    int mem_restore() {
+        if (future_.valid()) {
+            future_.wait(); // ensure prior run completed
+        }
+        if (!ram_.restore())
+            return -1;
+        mpm_cache_.clear();
+        return 0;
+    }
+
     int upload(uint64_t dest_addr, const void* src, uint64_t size) {
         uint64_t asize = aligned_size(size, CACHE_BLOCK_SIZE);
         if (dest_addr + asize > GLOBAL_MEM_SIZE)
@@ -467,6 +485,28 @@ extern int vx_mem_info(vx_device_h hdevice, uint64_t* mem_free, uint64_t* mem_us
     return 0;
 }
 
+extern int vx_mem_snapshot(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return -1;
+
+    auto device = ((vx_device*)hdevice);
+
+    DBGPRINT("MEM_SNAPSHOT: hdevice=%p\n", hdevice);
+
+    return device->mem_snapshot();
+}
+
+extern int vx_mem_restore(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return -1;
+
+    auto device = ((vx_device*)hdevice);
+
+    DBGPRINT("MEM_RESTORE: hdevice=%p\n", hdevice);
+
+    return device->mem_restore();
+}
+
 extern int vx_copy_to_dev(vx_buffer_h hbuffer, const void* host_ptr, uint64_t dst_offset, uint64_t size) {
     if (nullptr == hbuffer || nullptr == host_ptr)
         return -1;
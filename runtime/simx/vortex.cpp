@@ -50,6 +50,8 @@ using namespace vortex;
         _cleanup                                \
     } while (false)
 
+#define MAP_ALIGN_MIN_SIZE (1 << 20)
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class vx_device {
@@ -62,6 +64,42 @@ public:
     {
         // attach memory module
         processor_.attach_ram(&ram_);
+
+        // tick clusters in parallel
+        auto threads_s = getenv("VORTEX_SIMX_THREADS");
+        if (threads_s) {
+            processor_.set_num_threads(std::atoi(threads_s));
+        }
+
+        // run kernels without the timing model
+        auto functional_s = getenv("VORTEX_SIMX_FUNCTIONAL");
+        if (functional_s) {
+            processor_.set_functional(std::atoi(functional_s) != 0);
+        }
+
+        // simulate a detailed region, the rest of the kernel runs functionally
+        Processor::Region region = {};
+        auto region_instrs_s = getenv("VORTEX_SIMX_REGION_INSTRS");
+        if (region_instrs_s) {
+            region.start_instrs = std::strtoull(region_instrs_s, nullptr, 0);
+        }
+        auto region_pc_s = getenv("VORTEX_SIMX_REGION_PC");
+        if (region_pc_s) {
+            region.start_pc = std::strtoull(region_pc_s, nullptr, 0);
+        }
+        auto region_marker_s = getenv("VORTEX_SIMX_REGION_MARKER");
+        if (region_marker_s) {
+            region.marker = (std::atoi(region_marker_s) != 0);
+        }
+        auto region_cycles_s = getenv("VORTEX_SIMX_REGION_CYCLES");
+        if (region_cycles_s) {
+            region.max_cycles = std::strtoull(region_cycles_s, nullptr, 0);
+        }
+        auto region_warmup_s = getenv("VORTEX_SIMX_REGION_WARMUP");
+        if (region_warmup_s) {
+            region.warmup = std::atoi(region_warmup_s);
+        }
+        processor_.set_region(region);
     }
 
     ~vx_device() {
@@ -123,7 +161,9 @@ public:
 
     int mem_alloc(uint64_t size, int flags, uint64_t* dev_addr) {
         uint64_t addr;
-        CHECK_ERR(global_mem_.allocate(size, &addr), {
+        // large buffers are page aligned so that uploads from a mapped file can share its pages
+        uint64_t alignment = (size >= MAP_ALIGN_MIN_SIZE) ? RAM_PAGE_SIZE : 0;
+        CHECK_ERR(global_mem_.allocate(size, &addr, alignment), {
             return err;
         });
         CHECK_ERR(this->mem_access(addr, size, flags), {
@@ -166,13 +206,37 @@ public:
         return 0;
     }
 
+    int mem_snapshot() {
+        if (future_.valid()) {
+            future_.wait(); // ensure prior run completed
+        }
+        ram_.snapshot();
+        return 0;
+    }
+
+    int mem_restore() {
+        if (future_.valid()) {
+            future_.wait(); // ensure prior run completed
+        }
+        if (!ram_.restore())
+            return -1;
+        mpm_cache_.clear();
+        return 0;
+    }
+
     int upload(uint64_t dest_addr, const void* src, uint64_t size) {
         uint64_t asize = aligned_size(size, CACHE_BLOCK_SIZE);
         if (dest_addr + asize > GLOBAL_MEM_SIZE)
             return -1;
 
         ram_.enable_acl(false);
-        ram_.write((const uint8_t*)src, dest_addr, size);
+        auto file = MappedFile::find(src, size);
+        if (file) {
+            // install the file pages copy-on-write
+            ram_.map_file(file->fd(), (const uint8_t*)src - file->data(), size, dest_addr);
+        } else {
+            ram_.write((const uint8_t*)src, dest_addr, size);
+        }
         ram_.enable_acl(true);
 
         /*DBGPRINT("upload %ld bytes to 0x%lx\n", size, dest_addr);
@@ -217,6 +281,17 @@ public:
         // start new run
         future_ = std::async(std::launch::async, [&]{
             processor_.run();
+            auto region_stats = processor_.region_stats();
+            if (region_stats.cycles != 0) {
+                std::cout << std::dec << "PERF: region: start_cycle=" << region_stats.start_cycle
+                          << ", start_instrs=" << region_stats.start_instrs
+                          << ", cycles=" << region_stats.cycles
+                          << ", instrs=" << region_stats.instrs
+                          << ", loads=" << region_stats.loads
+                          << ", stores=" << region_stats.stores
+                          << ", mem_reads=" << region_stats.mem_reads
+                          << ", mem_writes=" << region_stats.mem_writes << std::endl;
+            }
         });
 
         // clear mpm cache
@@ -462,6 +537,28 @@ extern int vx_mem_info(vx_device_h hdevice, uint64_t* mem_free, uint64_t* mem_us
     return 0;
 }
 
+extern int vx_mem_snapshot(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return -1;
+
+    auto device = ((vx_device*)hdevice);
+
+    DBGPRINT("MEM_SNAPSHOT: hdevice=%p\n", hdevice);
+
+    return device->mem_snapshot();
+}
+
+extern int vx_mem_restore(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return -1;
+
+    auto device = ((vx_device*)hdevice);
+
+    DBGPRINT("MEM_RESTORE: hdevice=%p\n", hdevice);
+
+    return device->mem_restore();
+}
+
 extern int vx_copy_to_dev(vx_buffer_h hbuffer, const void* host_ptr, uint64_t dst_offset, uint64_t size) {
     if (nullptr == hbuffer || nullptr == host_ptr)
         return -1;
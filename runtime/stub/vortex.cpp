@@ -49,6 +49,14 @@ extern int vx_mem_info(vx_device_h /*hdevice*/, uint64_t* /*mem_free*/, uint64_t
     return 0;
 }
 
+extern int vx_mem_snapshot(vx_device_h /*hdevice*/) {
+    return -1;
+}
+
+extern int vx_mem_restore(vx_device_h /*hdevice*/) {
+    return -1;
+}
+
 extern int vx_copy_to_dev(vx_buffer_h /*hbuffer*/, const void* /*host_ptr*/, uint64_t /*dst_offset*/, uint64_t /*size*/) {
     return -1;
 }
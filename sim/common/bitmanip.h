@@ -24,6 +24,53 @@ constexpr uint32_t count_trailing_zeros(uint32_t value) {
   return value ? __builtin_ctz(value) : 32;
 }
 
+constexpr uint32_t count_leading_zeros(uint64_t value) {
+  return value ? __builtin_clzll(value) : 64;
+}
+
+constexpr uint32_t count_trailing_zeros(uint64_t value) {
+  return value ? __builtin_ctzll(value) : 64;
+}
+
+constexpr uint32_t count_ones(uint32_t value) {
+  return __builtin_popcount(value);
+}
+
+constexpr uint32_t count_ones(uint64_t value) {
+  return __builtin_popcountll(value);
+}
+
+template <typename T>
+constexpr T rotate_left(T value, uint32_t shift) {
+  return (value << (shift & (sizeof(T) * 8 - 1)))
+       | (value >> ((sizeof(T) * 8 - (shift & (sizeof(T) * 8 - 1))) & (sizeof(T) * 8 - 1)));
+}
+
+template <typename T>
+constexpr T rotate_right(T value, uint32_t shift) {
+  return rotate_left<T>(value, sizeof(T) * 8 - (shift & (sizeof(T) * 8 - 1)));
+}
+
+constexpr uint32_t byte_swap(uint32_t value) {
+  return __builtin_bswap32(value);
+}
+
+constexpr uint64_t byte_swap(uint64_t value) {
+  return __builtin_bswap64(value);
+}
+
+// set each non-zero byte to all ones
+template <typename T>
+inline T or_combine_bytes(T value) {
+  T result(0);
+  for (uint32_t i = 0; i < sizeof(T); ++i) {
+    if ((value >> (i * 8)) & 0xff) {
+      result |= T(0xff) << (i * 8);
+    }
+  }
+  return result;
+}
+
 constexpr bool ispow2(uint32_t value) {
   return value && !(value & (value - 1));
 }
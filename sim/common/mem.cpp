@@ -16,7 +16,14 @@
 #include <iostream>
 #include <fstream>
 #include <assert.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "util.h"
+#include "serialize.h"
 
 using namespace vortex;
 
@@ -190,6 +197,11 @@ void MemoryUnit::tlbRm(uint64_t va) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+ACLManager::ACLManager(uint32_t page_size)
+  : page_bits_(log2ceil(page_size))
+  , overflow_(false)
+{}
+
 void ACLManager::set(uint64_t addr, uint64_t size, int flags) {
   if (size == 0)
     return;
@@ -239,9 +251,66 @@ void ACLManager::set(uint64_t addr, uint64_t size, int flags) {
       acl_map_.erase(next);
     }
   }
+
+  // update the page table, only the boundary pages can be partly covered
+  uint64_t first = addr >> page_bits_;
+  uint64_t last = (end - 1) >> page_bits_;
+  if (last >= MAX_PAGES) {
+    overflow_ = true;
+    if (first >= MAX_PAGES)
+      return;
+    last = MAX_PAGES - 1;
+  }
+  if (last >= page_flags_.size()) {
+    page_flags_.resize(last + 1, 0xff);
+  }
+  uint8_t page_flags = flags ? (flags & 0xff) : 0xff;
+  for (uint64_t page = first + 1; page < last; ++page) {
+    page_flags_[page] = page_flags;
+  }
+  this->update_page(first);
+  this->update_page(last);
+}
+
+void ACLManager::update_page(uint64_t page_index) {
+  uint64_t start = page_index << page_bits_;
+  uint64_t end = start + (uint64_t(1) << page_bits_);
+  uint8_t page_flags = 0xff;
+  auto it = acl_map_.lower_bound(start);
+  if (it != acl_map_.begin() && std::prev(it)->second.end > start) {
+    --it;
+  }
+  while (it != acl_map_.end() && it->first < end) {
+    page_flags &= it->second.flags;
+    ++it;
+  }
+  page_flags_[page_index] = page_flags;
 }
 
 bool ACLManager::check(uint64_t addr, uint64_t size, int flags) const {
+  if (size != 0) {
+    // all the pages grant the flags to every byte
+    uint64_t first = addr >> page_bits_;
+    uint64_t last = (addr + size - 1) >> page_bits_;
+    uint64_t page = first;
+    for (; page <= last; ++page) {
+      int page_flags = 0xff;
+      if (page < page_flags_.size()) {
+        page_flags = page_flags_[page];
+      } else if (overflow_) {
+        break;
+      }
+      if ((page_flags & flags) != flags)
+        break;
+    }
+    if (page > last)
+      return true;
+  }
+  // sub-page ranges and violations
+  return this->check_ranges(addr, size, flags);
+}
+
+bool ACLManager::check_ranges(uint64_t addr, uint64_t size, int flags) const {
   uint64_t end = addr + size;
 
   auto it = acl_map_.lower_bound(addr);
@@ -265,11 +334,30 @@ bool ACLManager::check(uint64_t addr, uint64_t size, int flags) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// snapshot pages are shared read-only, their leaf pointer is tagged
+static inline bool is_frozen(const void* leaf) {
+  return (uintptr_t(leaf) & 0x1) != 0;
+}
+
+static inline uint8_t* page_ptr(const void* leaf) {
+  return (uint8_t*)(uintptr_t(leaf) & ~uintptr_t(0x1));
+}
+
+static inline void* freeze(uint8_t* ptr) {
+  return (void*)(uintptr_t(ptr) | 0x1);
+}
+
 RAM::RAM(uint64_t capacity, uint32_t page_size)
   : capacity_(capacity)
   , page_bits_(log2ceil(page_size))
+  , root_(new void*[RADIX_SIZE]())
+  , height_(1)
+  , num_pages_(0)
+  , snapshot_(false)
   , last_page_(nullptr)
   , last_page_index_(0)
+  , last_page_frozen_(false)
+  , acl_mngr_(page_size)
   , check_acl_(false) {
   assert(ispow2(page_size));
   if (capacity != 0) {
@@ -280,57 +368,173 @@ RAM::RAM(uint64_t capacity, uint32_t page_size)
 }
 
 RAM::~RAM() {
-  this->clear();
+  this->release();
 }
 
 void RAM::clear() {
-  for (auto& page : pages_) {
-    delete[] page.second;
+  this->release();
+  root_ = new void*[RADIX_SIZE]();
+  height_ = 1;
+  num_pages_ = 0;
+  last_page_ = nullptr;
+}
+
+void RAM::release() {
+  this->free_node(root_, height_ - 1);
+  for (auto& dirty : dirty_pages_) {
+    if (dirty.second) {
+      this->free_page(dirty.second);
+    }
+  }
+  dirty_pages_.clear();
+  snapshot_ = false;
+  for (auto& mapping : mappings_) {
+    munmap((void*)mapping.first, mapping.second);
+  }
+  mappings_.clear();
+}
+
+bool RAM::is_mapped(const uint8_t* ptr) const {
+  auto it = mappings_.upper_bound(ptr);
+  if (it == mappings_.begin())
+    return false;
+  --it;
+  return ptr < (it->first + it->second);
+}
+
+void RAM::free_page(uint8_t* ptr) {
+  if (!this->is_mapped(ptr)) {
+    delete[] ptr;
+  }
+}
+
+void RAM::free_node(void** node, uint32_t level) {
+  for (uint32_t i = 0; i < RADIX_SIZE; ++i) {
+    if (nullptr == node[i])
+      continue;
+    if (0 == level) {
+      this->free_page(page_ptr(node[i]));
+    } else {
+      this->free_node((void**)node[i], level - 1);
+    }
+  }
+  delete[] node;
+}
+
+void RAM::visit(void** node, uint32_t level, uint64_t base,
+                const std::function<void(uint64_t, void*&)>& callback) const {
+  for (uint32_t i = 0; i < RADIX_SIZE; ++i) {
+    if (nullptr == node[i])
+      continue;
+    uint64_t index = (base << RADIX_BITS) | i;
+    if (0 == level) {
+      callback(index, node[i]);
+    } else {
+      this->visit((void**)node[i], level - 1, index, callback);
+    }
   }
 }
 
 uint64_t RAM::size() const {
-  return uint64_t(pages_.size()) << page_bits_;
+  return num_pages_ << page_bits_;
 }
 
-uint8_t *RAM::get(uint64_t address) const {
+uint8_t *RAM::get(uint64_t address, bool write) const {
   if (capacity_ != 0 && address >= capacity_) {
     throw OutOfRange();
   }
   uint32_t page_size   = 1 << page_bits_;
   uint32_t page_offset = address & (page_size - 1);
   uint64_t page_index  = address >> page_bits_;
+  if (last_page_ && last_page_index_ == page_index && !(write && last_page_frozen_))
+    return last_page_ + page_offset;
+  return this->page(page_index, true, write) + page_offset;
+}
 
-  uint8_t* page;
-  if (last_page_ && last_page_index_ == page_index) {
-    page = last_page_;
-  } else {
-    auto it = pages_.find(page_index);
-    if (it != pages_.end()) {
-      page = it->second;
-    } else {
-      uint8_t *ptr = new uint8_t[page_size];
+void*& RAM::slot(uint64_t page_index) const {
+  // grow the tree until the root covers the index
+  while (height_ * RADIX_BITS < 64 && (page_index >> (height_ * RADIX_BITS)) != 0) {
+    auto node = new void*[RADIX_SIZE]();
+    node[0] = root_;
+    root_ = node;
+    ++height_;
+  }
+
+  void** node = root_;
+  for (uint32_t level = height_ - 1; level != 0; --level) {
+    auto& child = node[(page_index >> (level * RADIX_BITS)) & (RADIX_SIZE - 1)];
+    if (nullptr == child) {
+      child = new void*[RADIX_SIZE]();
+    }
+    node = (void**)child;
+  }
+
+  return node[page_index & (RADIX_SIZE - 1)];
+}
+
+uint8_t *RAM::page(uint64_t page_index, bool init, bool write) const {
+  if (last_page_ && last_page_index_ == page_index && !(write && last_page_frozen_))
+    return last_page_;
+
+  uint32_t page_size = 1 << page_bits_;
+  auto& leaf = this->slot(page_index);
+  if (nullptr == leaf) {
+    auto ptr = new uint8_t[page_size];
+    if (init) {
       // set uninitialized data to "baadf00d"
       for (uint32_t i = 0; i < page_size; ++i) {
         ptr[i] = (0xbaadf00d >> ((i & 0x3) * 8)) & 0xff;
       }
-      pages_.emplace(page_index, ptr);
-      page = ptr;
     }
-    last_page_ = page;
-    last_page_index_ = page_index;
+    leaf = ptr;
+    ++num_pages_;
+    if (snapshot_) {
+      dirty_pages_.emplace_back(page_index, nullptr);
+    }
+  } else if (write && is_frozen(leaf)) {
+    // copy the snapshot page on first write
+    auto ptr = new uint8_t[page_size];
+    if (init) {
+      std::memcpy(ptr, page_ptr(leaf), page_size);
+    }
+    dirty_pages_.emplace_back(page_index, page_ptr(leaf));
+    leaf = ptr;
   }
-
-  return page + page_offset;
+  last_page_ = page_ptr(leaf);
+  last_page_index_ = page_index;
+  last_page_frozen_ = is_frozen(leaf);
+  return last_page_;
 }
 
 void RAM::read(void* data, uint64_t addr, uint64_t size) {
   if (check_acl_ && acl_mngr_.check(addr, size, 0x1) == false) {
     throw BadAddress();
   }
+  if (0 == size)
+    return;
   uint8_t* d = (uint8_t*)data;
-  for (uint64_t i = 0; i < size; i++) {
-    d[i] = *this->get(addr + i);
+  uint64_t page_size = uint64_t(1) << page_bits_;
+  uint64_t offset = addr & (page_size - 1);
+  if (offset + size <= page_size) {
+    // single page, the emulator's word accesses
+    auto s = this->get(addr, false);
+    switch (size) {
+    case 1: std::memcpy(d, s, 1); break;
+    case 2: std::memcpy(d, s, 2); break;
+    case 4: std::memcpy(d, s, 4); break;
+    case 8: std::memcpy(d, s, 8); break;
+    default: std::memcpy(d, s, size); break;
+    }
+    return;
+  }
+  // copy page spans
+  while (size != 0) {
+    uint64_t chunk = std::min(size, page_size - offset);
+    std::memcpy(d, this->get(addr, false), chunk);
+    d += chunk;
+    addr += chunk;
+    size -= chunk;
+    offset = 0;
   }
 }
 
@@ -338,9 +542,40 @@ void RAM::write(const void* data, uint64_t addr, uint64_t size) {
   if (check_acl_ && acl_mngr_.check(addr, size, 0x2) == false) {
     throw BadAddress();
   }
+  if (0 == size)
+    return;
   const uint8_t* d = (const uint8_t*)data;
-  for (uint64_t i = 0; i < size; i++) {
-    *this->get(addr + i) = d[i];
+  uint64_t page_size = uint64_t(1) << page_bits_;
+  uint64_t offset = addr & (page_size - 1);
+  if (offset + size <= page_size) {
+    // single page, the emulator's word accesses
+    auto p = this->get(addr, true);
+    switch (size) {
+    case 1: std::memcpy(p, d, 1); break;
+    case 2: std::memcpy(p, d, 2); break;
+    case 4: std::memcpy(p, d, 4); break;
+    case 8: std::memcpy(p, d, 8); break;
+    default: std::memcpy(p, d, size); break;
+    }
+    return;
+  }
+  // copy page spans, whole pages are not initialized first
+  while (size != 0) {
+    uint64_t chunk = std::min(size, page_size - offset);
+    uint8_t* p;
+    if (chunk == page_size) {
+      if (capacity_ != 0 && addr >= capacity_) {
+        throw OutOfRange();
+      }
+      p = this->page(addr >> page_bits_, false, true);
+    } else {
+      p = this->get(addr, true);
+    }
+    std::memcpy(p, d, chunk);
+    d += chunk;
+    addr += chunk;
+    size -= chunk;
+    offset = 0;
   }
 }
 
@@ -351,21 +586,154 @@ void RAM::set_acl(uint64_t addr, uint64_t size, int flags) {
   acl_mngr_.set(addr, size, flags);
 }
 
+void RAM::map_file(int fd, uint64_t offset, uint64_t size, uint64_t destination) {
+  if (capacity_ != 0 && (destination + size) > capacity_) {
+    throw OutOfRange();
+  }
+  if (check_acl_ && acl_mngr_.check(destination, size, 0x2) == false) {
+    throw BadAddress();
+  }
+
+  // the file must line up with the pages to be mapped
+  uint64_t page_size = uint64_t(1) << page_bits_;
+  uint64_t head = 0;
+  uint64_t body = 0;
+  if (0 == (page_size % sysconf(_SC_PAGESIZE))
+   && (offset & (page_size - 1)) == (destination & (page_size - 1))) {
+    head = (page_size - (destination & (page_size - 1))) & (page_size - 1);
+    if (head < size) {
+      body = (size - head) & ~(page_size - 1);
+    }
+  }
+
+  uint8_t* ptr = nullptr;
+  if (body != 0) {
+    auto mem = mmap(nullptr, body, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset + head);
+    if (mem != MAP_FAILED) {
+      ptr = (uint8_t*)mem;
+    }
+  }
+  if (nullptr == ptr) {
+    this->copy_file(fd, offset, size, destination);
+    return;
+  }
+
+  this->copy_file(fd, offset, head, destination);
+  for (uint64_t i = 0; i < body; i += page_size) {
+    uint64_t page_index = (destination + head + i) >> page_bits_;
+    auto& leaf = this->slot(page_index);
+    if (nullptr == leaf) {
+      ++num_pages_;
+      if (snapshot_) {
+        dirty_pages_.emplace_back(page_index, nullptr);
+      }
+    } else if (is_frozen(leaf)) {
+      dirty_pages_.emplace_back(page_index, page_ptr(leaf));
+    } else {
+      this->free_page((uint8_t*)leaf);
+    }
+    leaf = ptr + i;
+  }
+  mappings_.emplace(ptr, body);
+  last_page_ = nullptr;
+  uint64_t tail = head + body;
+  this->copy_file(fd, offset + tail, size - tail, destination + tail);
+}
+
+void RAM::copy_file(int fd, uint64_t offset, uint64_t size, uint64_t destination) {
+  std::vector<uint8_t> buffer(std::min<uint64_t>(size, 1 << 20));
+  while (size != 0) {
+    auto ret = pread(fd, buffer.data(), std::min<uint64_t>(size, buffer.size()), offset);
+    if (ret <= 0) {
+      std::cout << "Error: failed to read file at offset " << offset << std::endl;
+      std::abort();
+    }
+    this->write(buffer.data(), destination, ret);
+    offset += ret;
+    destination += ret;
+    size -= ret;
+  }
+}
+
 void RAM::loadBinImage(const char* filename, uint64_t destination) {
-  std::ifstream ifs(filename);
-  if (!ifs) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
     std::cout << "error: " << filename << " not found" << std::endl;
     std::abort();
   }
 
-  ifs.seekg(0, ifs.end);
-  size_t size = ifs.tellg();
-  std::vector<uint8_t> content(size);
-  ifs.seekg(0, ifs.beg);
-  ifs.read((char*)content.data(), size);
+  struct stat st;
+  fstat(fd, &st);
+
+  // the image pages are mapped, the mapping outlives the descriptor
+  this->clear();
+  this->map_file(fd, 0, st.st_size, destination);
+  close(fd);
+}
+
+void RAM::save(std::ostream& os) const {
+  uint32_t page_size = 1 << page_bits_;
+  serialize(os, page_bits_);
+  serialize(os, num_pages_);
+
+  // the table walk visits the pages in address order
+  this->visit(root_, height_ - 1, 0, [&](uint64_t page_index, void*& leaf) {
+    serialize(os, page_index);
+    os.write((const char*)page_ptr(leaf), page_size);
+  });
+}
+
+void RAM::snapshot() {
+  // the pages replaced since the previous snapshot are not needed anymore
+  for (auto& dirty : dirty_pages_) {
+    if (dirty.second) {
+      this->free_page(dirty.second);
+    }
+  }
+  dirty_pages_.clear();
+  this->visit(root_, height_ - 1, 0, [&](uint64_t, void*& leaf) {
+    leaf = freeze(page_ptr(leaf));
+  });
+  snapshot_ = true;
+  last_page_ = nullptr;
+}
+
+bool RAM::restore() {
+  if (!snapshot_)
+    return false;
+  for (auto& dirty : dirty_pages_) {
+    auto& leaf = this->slot(dirty.first);
+    this->free_page(page_ptr(leaf));
+    if (dirty.second) {
+      leaf = freeze(dirty.second);
+    } else {
+      leaf = nullptr;
+      --num_pages_;
+    }
+  }
+  dirty_pages_.clear();
+  last_page_ = nullptr;
+  return true;
+}
+
+void RAM::load(std::istream& is) {
+  uint32_t page_bits = 0;
+  deserialize(is, page_bits);
+  if (is && page_bits != page_bits_) {
+    std::cout << "Error: checkpoint RAM page size mismatch" << std::endl;
+    std::abort();
+  }
 
   this->clear();
-  this->write(content.data(), destination, size);
+
+  uint32_t page_size = 1 << page_bits_;
+  uint64_t num_pages = 0;
+  deserialize(is, num_pages);
+  for (uint64_t i = 0; i < num_pages && is; ++i) {
+    uint64_t page_index = 0;
+    deserialize(is, page_index);
+    is.read((char*)this->page(page_index, false, true), page_size);
+  }
 }
 
 void RAM::loadHexImage(const char* filename) {
@@ -412,7 +780,7 @@ void RAM::loadHexImage(const char* filename) {
         for (uint32_t i = 0; i < byteCount; i++) {
           uint32_t addr  = nextAddr + i;
           uint32_t value = hToI(line + 9 + i * 2, 2);
-          *this->get(addr) = value;
+          *this->get(addr, true) = value;
         }
         break;
       case 2:
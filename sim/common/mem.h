@@ -18,6 +18,8 @@
 #include <map>
 #include <unordered_map>
 #include <cstdint>
+#include <functional>
+#include <iosfwd>
 
 namespace vortex {
 struct BadAddress {};
@@ -159,18 +161,31 @@ private:
 class ACLManager {
 public:
 
+    ACLManager(uint32_t page_size);
+
     void set(uint64_t addr, uint64_t size, int flags);
 
     bool check(uint64_t addr, uint64_t size, int flags) const;
 
 private:
 
+  // pages past the table limit always check the ranges
+  enum { MAX_PAGES = (1 << 24) };
+
+  bool check_ranges(uint64_t addr, uint64_t size, int flags) const;
+
+  void update_page(uint64_t page_index);
+
   struct acl_entry_t {
     uint64_t end;
     int32_t flags;
   };
 
   std::map<uint64_t, acl_entry_t> acl_map_;
+  // flags granted to every byte of the page, bytes without a range grant all
+  std::vector<uint8_t> page_flags_;
+  uint32_t page_bits_;
+  bool overflow_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -192,12 +207,25 @@ public:
   void loadBinImage(const char* filename, uint64_t destination);
   void loadHexImage(const char* filename);
 
+  // install the file's pages as copy-on-write pages,
+  // the ranges that do not line up with whole pages are copied.
+  void map_file(int fd, uint64_t offset, uint64_t size, uint64_t destination);
+
+  // checkpoint the allocated pages
+  void save(std::ostream& os) const;
+  void load(std::istream& is);
+
+  // copy-on-write snapshot of the memory content, restore() only puts
+  // back the pages changed since and returns false without a snapshot.
+  void snapshot();
+  bool restore();
+
   uint8_t& operator[](uint64_t address) {
-    return *this->get(address);
+    return *this->get(address, true);
   }
 
   const uint8_t& operator[](uint64_t address) const {
-    return *this->get(address);
+    return *this->get(address, false);
   }
 
   void set_acl(uint64_t addr, uint64_t size, int flags);
@@ -208,13 +236,40 @@ public:
 
 private:
 
-  uint8_t *get(uint64_t address) const;
+  uint8_t *get(uint64_t address, bool write) const;
+
+  uint8_t *page(uint64_t page_index, bool init, bool write) const;
+
+  void*& slot(uint64_t page_index) const;
+
+  void copy_file(int fd, uint64_t offset, uint64_t size, uint64_t destination);
+
+  bool is_mapped(const uint8_t* ptr) const;
+
+  void free_page(uint8_t* ptr);
+
+  void release();
+
+  void free_node(void** node, uint32_t level);
+
+  void visit(void** node, uint32_t level, uint64_t base,
+             const std::function<void(uint64_t, void*&)>& callback) const;
+
+  // radix page table levels, the root grows as higher addresses get used
+  enum { RADIX_BITS = 12, RADIX_SIZE = (1 << RADIX_BITS) };
 
   uint64_t capacity_;
   uint32_t page_bits_;
-  mutable std::unordered_map<uint64_t, uint8_t*> pages_;
+  mutable void** root_;
+  mutable uint32_t height_;
+  mutable uint64_t num_pages_;
+  std::map<const uint8_t*, uint64_t> mappings_;
+  // pages changed since the snapshot with their snapshot copy, if any
+  mutable std::vector<std::pair<uint64_t, uint8_t*>> dirty_pages_;
+  bool snapshot_;
   mutable uint8_t* last_page_;
   mutable uint64_t last_page_index_;
+  mutable bool last_page_frozen_;
   ACLManager acl_mngr_;
   bool check_acl_;
 };
@@ -13,50 +13,130 @@
 
 #pragma once
 
-#include <stack>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
 
+// Slab arena for fixed-size objects: memory is carved out of slabs of
+// 'slab_size' objects and recycled through an intrusive free list.
+// Slabs are only returned to the system when the pool is destroyed.
+// Each object remembers its pool, objects released by another thread
+// go back to their owner through a lock-free list.
 template <typename T>
 class MemoryPool {
 public:  
-  MemoryPool(uint32_t max_size) : max_size_(max_size) {}
-
-  MemoryPool(MemoryPool && other) 
-    : free_list_(std::move(other.free_list_)) 
+  MemoryPool(uint32_t slab_size) 
+    : free_list_(nullptr)
+    , remote_list_(nullptr)
+    , slab_size_(slab_size) 
   {}
 
   ~MemoryPool() {
     this->flush();
   }
 
+  // per-thread pool kept alive until exit: objects may be released
+  // by another thread than the one that allocated them.
+  static MemoryPool& thread_instance(uint32_t slab_size) {
+    static thread_local MemoryPool* instance = nullptr;
+    if (nullptr == instance) {
+      auto& pools = thread_pools();
+      std::lock_guard<std::mutex> lock(pools.mutex);
+      pools.list.emplace_back(new MemoryPool(slab_size));
+      instance = pools.list.back().get();
+    }
+    return *instance;
+  }
+
+  // slabs held by all the per-thread pools
+  static uint32_t thread_slabs() {
+    auto& pools = thread_pools();
+    std::lock_guard<std::mutex> lock(pools.mutex);
+    uint32_t count = 0;
+    for (auto& pool : pools.list) {
+      count += pool->num_slabs();
+    }
+    return count;
+  }
+
   void* allocate() {
-    void* mem;
-    if (!free_list_.empty()) {
-      auto entry = free_list_.top();
-      free_list_.pop();
-      mem = static_cast<void*>(entry);      
-    } else {
-      mem = ::operator new(sizeof(T));
+    if (nullptr == free_list_) {
+      // reclaim the objects released by other threads first
+      free_list_ = remote_list_.exchange(nullptr, std::memory_order_acquire);
+      if (nullptr == free_list_) {
+        this->grow();
+      }
     }
-    return mem;
+    auto node = free_list_;
+    free_list_ = node->next;
+    return static_cast<void*>(&node->storage);
   }
 
   void deallocate(void * object) {
-    if (free_list_.size() < max_size_) {
-      free_list_.push(static_cast<T*>(object));
-    } else {
-      ::operator delete(object);
+    auto node = reinterpret_cast<node_t*>(static_cast<uint8_t*>(object) - offsetof(node_t, storage));
+    if (node->owner != this) {
+      node->owner->release_remote(node);
+      return;
     }
+    node->next = free_list_;
+    free_list_ = node;
   }
 
   void flush() {
-    while (!free_list_.empty()) {
-      auto entry = free_list_.top();
-      free_list_.pop();
-      ::operator delete(entry);      
+    for (auto slab : slabs_) {
+      ::operator delete(slab);
     }
+    slabs_.clear();
+    free_list_ = nullptr;
+    remote_list_ = nullptr;
+  }
+
+  uint32_t num_slabs() const {
+    return slabs_.size();
   }
 
 private:
-  std::stack<T*> free_list_;
-  uint32_t max_size_;
+  struct node_t {
+    MemoryPool* owner;
+    union {
+      node_t* next;
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+  };
+
+  struct thread_pools_t {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<MemoryPool>> list;
+  };
+
+  static thread_pools_t& thread_pools() {
+    static thread_pools_t pools;
+    return pools;
+  }
+
+  void release_remote(node_t* node) {
+    node->next = remote_list_.load(std::memory_order_relaxed);
+    while (!remote_list_.compare_exchange_weak(node->next, node,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+  }
+
+  void grow() {
+    auto slab = static_cast<node_t*>(::operator new(slab_size_ * sizeof(node_t)));
+    slabs_.push_back(slab);
+    for (uint32_t i = 0; i < slab_size_; ++i) {
+      slab[i].owner = this;
+      slab[i].next = free_list_;
+      free_list_ = &slab[i];
+    }
+  }
+
+  node_t* free_list_;
+  std::atomic<node_t*> remote_list_;
+  std::vector<node_t*> slabs_;
+  uint32_t slab_size_;
 };
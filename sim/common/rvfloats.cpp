@@ -13,6 +13,8 @@
 
 #include "rvfloats.h"
 #include <stdio.h>
+#include <string.h>
+#include <cmath>
 
 extern "C" {
 #include <softfloat.h>
@@ -34,11 +36,132 @@ inline void rv_init(uint32_t frm) {
   softfloat_roundingMode = frm;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// Host fast path: under round-to-nearest-even the SSE arithmetic is
+// bit-exact with softfloat as long as the host raises no flag other than
+// inexact and the result is not a NaN. NaN propagation, invalid operations,
+// overflow, tininess and denormal operands are left to softfloat.
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RV_NATIVE_FLOATS
+#include <xmmintrin.h>
+#endif
+
+static bool native_enabled = true;
+
+inline float f32_value(uint32_t x) { float f; memcpy(&f, &x, sizeof(f)); return f; }
+inline double f64_value(uint64_t x) { double f; memcpy(&f, &x, sizeof(f)); return f; }
+
+inline uint32_t f32_bits(float f) { uint32_t x; memcpy(&x, &f, sizeof(x)); return x; }
+inline uint64_t f64_bits(double f) { uint64_t x; memcpy(&x, &f, sizeof(x)); return x; }
+
+#ifdef RV_NATIVE_FLOATS
+
+#define MXCSR_FLAGS   0x003f
+#define MXCSR_INEXACT 0x0020
+#define MXCSR_MODES   0xe040 // rounding, flush-to-zero, denormals-are-zero
+
+// keep the host operations between the MXCSR accesses
+template <typename T>
+inline T native_fence(T x) {
+  __asm__ volatile("" : "+x"(x));
+  return x;
+}
+
+__attribute__((target("fma")))
+static float native_fma(float a, float b, float c) { return __builtin_fmaf(a, b, c); }
+
+__attribute__((target("fma")))
+static double native_fma(double a, double b, double c) { return __builtin_fma(a, b, c); }
+
+inline bool native_has_fma() {
+  static const bool supported = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("fma") != 0;
+  }();
+  return supported;
+}
+
+template <typename Op, typename T>
+inline bool native_op(uint32_t frm, uint32_t* fflags, T* result, T a, T b = 0, T c = 0) {
+  if (frm != softfloat_round_near_even || !native_enabled)
+    return false;
+  uint32_t csr = _mm_getcsr();
+  if (csr & MXCSR_MODES)
+    return false;
+  _mm_setcsr(csr & ~MXCSR_FLAGS);
+  T r = native_fence(Op()(native_fence(a), native_fence(b), native_fence(c)));
+  uint32_t flags = _mm_getcsr() & MXCSR_FLAGS;
+  if ((flags & ~MXCSR_INEXACT) || std::isnan(r))
+    return false;
+  if (fflags) { *fflags = (flags != 0) ? softfloat_flag_inexact : 0; }
+  *result = r;
+  return true;
+}
+
+#else
+
+inline bool native_has_fma() { return false; }
+
+template <typename Op, typename T>
+inline bool native_op(uint32_t, uint32_t*, T*, T, T = 0, T = 0) {
+  return false;
+}
+
+#endif
+
+struct NativeAdd {
+  template <typename T> T operator()(T a, T b, T) const { return a + b; }
+};
+
+struct NativeSub {
+  template <typename T> T operator()(T a, T b, T) const { return a - b; }
+};
+
+struct NativeMul {
+  template <typename T> T operator()(T a, T b, T) const { return a * b; }
+};
+
+struct NativeDiv {
+  template <typename T> T operator()(T a, T b, T) const { return a / b; }
+};
+
+#ifdef RV_NATIVE_FLOATS
+
+struct NativeSqrt {
+  float operator()(float a, float, float) const { return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(a))); }
+  double operator()(double a, double, double) const { return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(a))); }
+};
+
+struct NativeFma {
+  template <typename T> T operator()(T a, T b, T c) const { return native_fma(a, b, c); }
+};
+
+#else
+
+struct NativeSqrt {
+  template <typename T> T operator()(T a, T, T) const { return a; }
+};
+
+struct NativeFma {
+  template <typename T> T operator()(T a, T, T) const { return a; }
+};
+
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+void rv_set_native(bool enable) {
+  native_enabled = enable;
+}
+
 uint32_t rv_fadd_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_op<NativeAdd>(frm, fflags, &n, f32_value(a), f32_value(b)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_add(to_float32_t(a), to_float32_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -46,6 +169,9 @@ uint32_t rv_fadd_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint64_t rv_fadd_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_op<NativeAdd>(frm, fflags, &n, f64_value(a), f64_value(b)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_add(to_float64_t(a), to_float64_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -53,6 +179,9 @@ uint64_t rv_fadd_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint32_t rv_fsub_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_op<NativeSub>(frm, fflags, &n, f32_value(a), f32_value(b)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_sub(to_float32_t(a), to_float32_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -60,6 +189,9 @@ uint32_t rv_fsub_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint64_t rv_fsub_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_op<NativeSub>(frm, fflags, &n, f64_value(a), f64_value(b)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_sub(to_float64_t(a), to_float64_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -67,6 +199,9 @@ uint64_t rv_fsub_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint32_t rv_fmul_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_op<NativeMul>(frm, fflags, &n, f32_value(a), f32_value(b)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_mul(to_float32_t(a), to_float32_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -74,6 +209,9 @@ uint32_t rv_fmul_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint64_t rv_fmul_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_op<NativeMul>(frm, fflags, &n, f64_value(a), f64_value(b)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_mul(to_float64_t(a), to_float64_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -81,6 +219,10 @@ uint64_t rv_fmul_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint32_t rv_fmadd_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f32_value(a), f32_value(b), f32_value(c)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_mulAdd(to_float32_t(a), to_float32_t(b), to_float32_t(c));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -88,6 +230,10 @@ uint32_t rv_fmadd_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t*
 }
 
 uint64_t rv_fmadd_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f64_value(a), f64_value(b), f64_value(c)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_mulAdd(to_float64_t(a), to_float64_t(b), to_float64_t(c));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -95,6 +241,10 @@ uint64_t rv_fmadd_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t*
 }
 
 uint32_t rv_fmsub_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f32_value(a), f32_value(b), f32_value(c ^ F32_SIGN)))
+    return f32_bits(n);
   rv_init(frm);
   auto c_neg = c ^ F32_SIGN;
   auto r = f32_mulAdd(to_float32_t(a), to_float32_t(b), to_float32_t(c_neg));
@@ -103,6 +253,10 @@ uint32_t rv_fmsub_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t*
 }
 
 uint64_t rv_fmsub_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f64_value(a), f64_value(b), f64_value(c ^ F64_SIGN)))
+    return f64_bits(n);
   rv_init(frm);
   auto c_neg = c ^ F64_SIGN;
   auto r = f64_mulAdd(to_float64_t(a), to_float64_t(b), to_float64_t(c_neg));
@@ -111,6 +265,10 @@ uint64_t rv_fmsub_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t*
 }
 
 uint32_t rv_fnmadd_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f32_value(a ^ F32_SIGN), f32_value(b), f32_value(c ^ F32_SIGN)))
+    return f32_bits(n);
   rv_init(frm);
   auto a_neg = a ^ F32_SIGN;
   auto c_neg = c ^ F32_SIGN;
@@ -120,6 +278,10 @@ uint32_t rv_fnmadd_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t*
 }
 
 uint64_t rv_fnmadd_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f64_value(a ^ F64_SIGN), f64_value(b), f64_value(c ^ F64_SIGN)))
+    return f64_bits(n);
   rv_init(frm);
   auto a_neg = a ^ F64_SIGN;
   auto c_neg = c ^ F64_SIGN;
@@ -129,6 +291,10 @@ uint64_t rv_fnmadd_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t*
 }
 
 uint32_t rv_fnmsub_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f32_value(a ^ F32_SIGN), f32_value(b), f32_value(c)))
+    return f32_bits(n);
   rv_init(frm);
   auto a_neg = a ^ F32_SIGN;
   auto r = f32_mulAdd(to_float32_t(a_neg), to_float32_t(b), to_float32_t(c));
@@ -137,6 +303,10 @@ uint32_t rv_fnmsub_s(uint32_t a, uint32_t b, uint32_t c, uint32_t frm, uint32_t*
 }
 
 uint64_t rv_fnmsub_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_has_fma()
+   && native_op<NativeFma>(frm, fflags, &n, f64_value(a ^ F64_SIGN), f64_value(b), f64_value(c)))
+    return f64_bits(n);
   rv_init(frm);
   auto a_neg = a ^ F64_SIGN;
   auto r = f64_mulAdd(to_float64_t(a_neg), to_float64_t(b), to_float64_t(c));
@@ -145,6 +315,9 @@ uint64_t rv_fnmsub_d(uint64_t a, uint64_t b, uint64_t c, uint32_t frm, uint32_t*
 }
 
 uint32_t rv_fdiv_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_op<NativeDiv>(frm, fflags, &n, f32_value(a), f32_value(b)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_div(to_float32_t(a), to_float32_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -152,6 +325,9 @@ uint32_t rv_fdiv_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint64_t rv_fdiv_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_op<NativeDiv>(frm, fflags, &n, f64_value(a), f64_value(b)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_div(to_float64_t(a), to_float64_t(b));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -159,6 +335,9 @@ uint64_t rv_fdiv_d(uint64_t a, uint64_t b, uint32_t frm, uint32_t* fflags) {
 }
 
 uint32_t rv_fsqrt_s(uint32_t a, uint32_t frm, uint32_t* fflags) {
+  float n;
+  if (native_op<NativeSqrt>(frm, fflags, &n, f32_value(a)))
+    return f32_bits(n);
   rv_init(frm);
   auto r = f32_sqrt(to_float32_t(a));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
@@ -166,6 +345,9 @@ uint32_t rv_fsqrt_s(uint32_t a, uint32_t frm, uint32_t* fflags) {
 }
 
 uint64_t rv_fsqrt_d(uint64_t a, uint32_t frm, uint32_t* fflags) {
+  double n;
+  if (native_op<NativeSqrt>(frm, fflags, &n, f64_value(a)))
+    return f64_bits(n);
   rv_init(frm);
   auto r = f64_sqrt(to_float64_t(a));
   if (fflags) { *fflags = softfloat_exceptionFlags; }
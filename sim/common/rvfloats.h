@@ -19,6 +19,10 @@
 extern "C" {
 #endif
 
+// use the host FPU for round-to-nearest-even arithmetic when bit-exact,
+// enabled by default.
+void rv_set_native(bool enable);
+
 uint32_t rv_fadd_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags);
 uint32_t rv_fsub_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags);
 uint32_t rv_fmul_s(uint32_t a, uint32_t b, uint32_t frm, uint32_t* fflags);
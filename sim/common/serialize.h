@@ -0,0 +1,81 @@
+// Copyright © 2019-2023
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <bitset>
+#include <type_traits>
+
+namespace vortex {
+
+// binary encoding of the simulator state for checkpoints,
+// the files are only meant to be read back on the same host type.
+
+template <typename T>
+void serialize(std::ostream& os, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "invalid type");
+  os.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+void deserialize(std::istream& is, T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "invalid type");
+  is.read((char*)&value, sizeof(T));
+}
+
+template <size_t N>
+void serialize(std::ostream& os, const std::bitset<N>& value) {
+  for (size_t i = 0; i < N; i += 64) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 64 && (i + j) < N; ++j) {
+      word |= uint64_t(value.test(i + j)) << j;
+    }
+    serialize(os, word);
+  }
+}
+
+template <size_t N>
+void deserialize(std::istream& is, std::bitset<N>& value) {
+  for (size_t i = 0; i < N; i += 64) {
+    uint64_t word = 0;
+    deserialize(is, word);
+    for (size_t j = 0; j < 64 && (i + j) < N; ++j) {
+      value.set(i + j, (word >> j) & 0x1);
+    }
+  }
+}
+
+template <typename T>
+void serialize(std::ostream& os, const std::vector<T>& value) {
+  serialize(os, uint64_t(value.size()));
+  for (auto& element : value) {
+    serialize(os, element);
+  }
+}
+
+template <typename T>
+void deserialize(std::istream& is, std::vector<T>& value) {
+  uint64_t size = 0;
+  deserialize(is, size);
+  if (!is)
+    return;
+  value.resize(size);
+  for (auto& element : value) {
+    deserialize(is, element);
+  }
+}
+
+}
@@ -13,12 +13,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <list>
 #include <queue>
+#include <atomic>
+#include <thread>
 #include <assert.h>
 #include "mempool.h"
 
@@ -34,14 +37,22 @@ public:
     return module_;
   }
 
+  // object woken up when a packet lands on this port,
+  // modules draining another object's port redirect it to themselves.
+  void listener(SimObjectBase* listener) {
+    listener_ = listener;
+  }
+
 protected:
   SimPortBase(SimObjectBase* module)
     : module_(module)
+    , listener_(module)
   {}
 
   SimPortBase& operator=(const SimPortBase&) = delete;
 
   SimObjectBase* module_;
+  SimObjectBase* listener_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,11 +62,20 @@ class SimPort : public SimPortBase {
 public:
   typedef std::function<void (const Pkt&, uint64_t)> TxCallback;
 
-  SimPort(SimObjectBase* module)
+  // a non-zero capacity (power of two) makes the port fixed-size:
+  // producers are expected to check full() before pushing.
+  SimPort(SimObjectBase* module, uint32_t capacity = 0)
     : SimPortBase(module)
+    , queue_(capacity)
+    , head_(0)
+    , size_(0)
+    , capacity_(capacity)
+    , pending_(0)
     , peer_(nullptr)
     , tx_cb_(nullptr)
-  {}
+  {
+    assert(0 == (capacity & (capacity - 1)));
+  }
 
   void bind(SimPort<Pkt>* peer) {
     assert(peer_ == nullptr);
@@ -75,22 +95,41 @@ public:
   }
 
   bool empty() const {
-    return queue_.empty();
+    return (0 == size_);
+  }
+
+  uint32_t size() const {
+    return size_;
+  }
+
+  uint32_t capacity() const {
+    return capacity_;
+  }
+
+  // packets in flight to a fixed-size port count against its capacity
+  bool full() const {
+    if (peer_ && !tx_cb_)
+      return peer_->full();
+    return (capacity_ != 0) && ((size_ + pending_) >= capacity_);
   }
 
   const Pkt& front() const {
-    return queue_.front();
+    assert(size_ != 0);
+    return queue_[head_].pkt;
   }
 
   Pkt& front() {
-    return queue_.front().pkt;
+    assert(size_ != 0);
+    return queue_[head_].pkt;
   }
 
   void push(const Pkt& pkt, uint64_t delay = 1) const;
 
   uint64_t pop() {
-    auto cycles = queue_.front().cycles;
-    queue_.pop();
+    assert(size_ != 0);
+    auto cycles = queue_[head_].cycles;
+    head_ = (head_ + 1) & (queue_.size() - 1);
+    --size_;
     return cycles;
   }  
 
@@ -99,9 +138,9 @@ public:
   }
 
   uint64_t arrival_time() const {
-    if (queue_.empty())
+    if (0 == size_)
       return 0;
-    return queue_.front().cycles;
+    return queue_[head_].cycles;
   }
 
 protected:
@@ -110,19 +149,33 @@ protected:
     uint64_t cycles;
   };
 
-  std::queue<timed_pkt_t> queue_;
+  // packets are kept in a power-of-two ring buffer that only grows,
+  // so a port in steady state never touches the heap.
+  std::vector<timed_pkt_t> queue_;
+  uint32_t   head_;
+  uint32_t   size_;
+  uint32_t   capacity_;
+  mutable uint32_t pending_;
   SimPort*   peer_;
   TxCallback tx_cb_;
 
   void transfer(const Pkt& data, uint64_t cycles) {
-    if (tx_cb_) {
-      tx_cb_(data, cycles);
+    if (capacity_ && !peer_) {
+      assert(pending_ != 0);
+      --pending_;
     }
-    if (peer_) {
-      peer_->transfer(data, cycles);
-    } else {
-      queue_.push({data, cycles});
+    this->deliver(data, cycles);
+  }
+
+  void deliver(const Pkt& data, uint64_t cycles);
+
+  void grow() {
+    std::vector<timed_pkt_t> queue(queue_.empty() ? 4 : (queue_.size() * 2));
+    for (uint32_t i = 0; i < size_; ++i) {
+      queue[i] = queue_[(head_ + i) & (queue_.size() - 1)];
     }
+    queue_.swap(queue);
+    head_ = 0;
   }
 
   SimPort& operator=(const SimPort&) = delete;
@@ -134,8 +187,6 @@ protected:
 
 class SimEventBase {
 public:
-  typedef std::shared_ptr<SimEventBase> Ptr;
-
   virtual ~SimEventBase() {}
   
   virtual void fire() const = 0;
@@ -145,22 +196,31 @@ public:
   }
 
 protected:
-  SimEventBase(uint64_t cycles) : cycles_(cycles) {}
+  SimEventBase(uint64_t cycles) 
+    : next_(nullptr)
+    , cycles_(cycles) 
+  {}
 
-  uint64_t cycles_;
+  // events are singly owned by the platform from scheduling until they fire,
+  // after which they are handed back to their arena.
+  virtual void release() = 0;
+
+  SimEventBase* next_;
+  uint64_t      cycles_;
+
+  friend class SimPartition;
+  friend class SimPlatform;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-template <typename Pkt>
+template <typename Pkt, typename Func>
 class SimCallEvent : public SimEventBase {
 public:
   void fire() const override {
     func_(pkt_);
   }
 
-  typedef std::function<void (const Pkt&)> Func;
-
   SimCallEvent(const Func& func, const Pkt& pkt, uint64_t cycles) 
     : SimEventBase(cycles)
     , func_(func)
@@ -176,12 +236,16 @@ public:
   }
 
 protected:
+  void release() override {
+    delete this;
+  }
+
   Func func_;
   Pkt  pkt_;
 
-  static MemoryPool<SimCallEvent<Pkt>>& allocator() {
-    static MemoryPool<SimCallEvent<Pkt>> instance(64);
-    return instance;
+  // events may be released by another partition's thread
+  static MemoryPool<SimCallEvent<Pkt, Func>>& allocator() {
+    return MemoryPool<SimCallEvent<Pkt, Func>>::thread_instance(64);
   }
 };
 
@@ -209,18 +273,23 @@ public:
   }
 
 protected:
+  void release() override {
+    delete this;
+  }
+
   const SimPort<Pkt>* port_; 
   Pkt pkt_;
 
   static MemoryPool<SimPortEvent<Pkt>>& allocator() {
-    static MemoryPool<SimPortEvent<Pkt>> instance(64);
-    return instance;
+    return MemoryPool<SimPortEvent<Pkt>>::thread_instance(64);
   }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class SimContext;
+class SimPartition;
+class SimPlatform;
 
 class SimObjectBase {
 public:
@@ -232,18 +301,53 @@ public:
     return name_;
   } 
 
+  // platform simulating this object
+  SimPlatform& platform() const {
+    return *platform_;
+  }
+
+  // resume ticking a sleeping object
+  void wakeup();
+
 protected:
 
   SimObjectBase(const SimContext& ctx, const char* name); 
 
+  // stop ticking this object until a packet is delivered to one of its ports
+  // or it is woken up, only valid when its next ticks would have no effect.
+  void sleep();
+
+  // flag the object as waiting for this cycle: until it is woken up, its ticks
+  // reduce to per-cycle bookkeeping that skip() can apply in bulk.
+  void idle();
+
+  // a clocked object keeps being ticked while the platform fast-forwards,
+  // this is set at construction.
+  void clocked(bool enable) {
+    clocked_ = enable;
+  }
+
+  // call tock() once every partition has ticked this cycle. Tocks run one
+  // at a time in creation order, for work on state shared across partitions.
+  void request_tock();
+
 private:
 
   virtual void do_reset() = 0;
 
   virtual void do_tick() = 0;
 
-  std::string name_;
+  virtual void do_tock() = 0;
 
+  virtual void do_skip(uint64_t cycles) = 0;
+
+  std::string   name_;
+  SimPlatform*  platform_;
+  SimPartition* partition_;
+  uint32_t      index_;
+  bool          clocked_;
+
+  friend class SimPartition;
   friend class SimPlatform;
 };
 
@@ -254,8 +358,10 @@ class SimObject : public SimObjectBase {
 public:
   typedef std::shared_ptr<Impl> Ptr;
 
+  // objects are created on the platform of the given context,
+  // sub-objects pass down the context their parent was constructed with.
   template <typename... Args>
-  static Ptr Create(Args&&... args);
+  static Ptr Create(const SimContext& ctx, Args&&... args);
 
 protected:
 
@@ -263,6 +369,10 @@ protected:
     : SimObjectBase(ctx, name) 
   {}
 
+  void tock() {}
+
+  void skip(uint64_t /*cycles*/) {}
+
 private:
 
   const Impl* impl() const {
@@ -280,22 +390,295 @@ private:
   void do_tick() override {
     this->impl()->tick();
   }
+
+  void do_tock() override {
+    this->impl()->tock();
+  }
+
+  void do_skip(uint64_t cycles) override {
+    this->impl()->skip(cycles);
+  }
 };
 
 class SimContext {
+public:
+  SimPlatform* platform() const {
+    return platform_;
+  }
+
 private:    
-  SimContext() {}
+  SimContext(SimPlatform* platform) 
+    : platform_(platform) 
+  {}
+
+  SimPlatform* platform_;
   
   friend class SimPlatform;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// A group of objects ticked in creation order by a single thread, with its
+// own timing wheel. Events posted to another partition are held in a
+// per-destination mailbox until the end of the cycle.
+class SimPartition {
+public:
+  SimPartition(uint32_t id)
+    : id_(id)
+    , wheel_(WHEEL_SIZE, bucket_t{nullptr, nullptr})
+    , overflow_order_(0)
+    , has_mail_(false)
+  {}
+
+private:
+
+  // timing wheel size (must be a power of two)
+  static constexpr uint32_t WHEEL_SIZE = 256;
+  static constexpr uint32_t WHEEL_MASK = WHEEL_SIZE - 1;
+
+  struct bucket_t {
+    SimEventBase* head;
+    SimEventBase* tail;
+  };
+
+  struct overflow_entry_t {
+    SimEventBase* event;
+    uint64_t order;
+  };
+
+  struct overflow_compare_t {
+    bool operator()(const overflow_entry_t& lhs, const overflow_entry_t& rhs) const {
+      // min-heap on due cycle, ties resolved in scheduling order
+      if (lhs.event->cycles() != rhs.event->cycles())
+        return lhs.event->cycles() > rhs.event->cycles();
+      return lhs.order > rhs.order;
+    }
+  };
+
+  typedef std::priority_queue<overflow_entry_t,
+                              std::vector<overflow_entry_t>,
+                              overflow_compare_t> overflow_queue_t;
+
+  void add_object(SimObjectBase* object) {
+    object->partition_ = this;
+    object->index_ = objects_.size();
+    objects_.push_back(object);
+    if (0 == (object->index_ & 63)) {
+      active_.push_back(0);
+      idle_.push_back(0);
+      clocked_.push_back(0);
+    }
+    this->activate(object->index_);
+    if (object->clocked_) {
+      clocked_.back() |= (uint64_t(1) << (object->index_ & 63));
+    }
+  }
+
+  void activate(uint32_t index) {
+    active_[index >> 6] |= (uint64_t(1) << (index & 63));
+    idle_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+  }
+
+  void deactivate(uint32_t index) {
+    active_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    idle_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+  }
+
+  void set_idle(uint32_t index) {
+    idle_[index >> 6] |= (uint64_t(1) << (index & 63));
+  }
+
+  void reset() {
+    this->clear_events();
+    for (auto& word : idle_) {
+      word = 0;
+    }
+    for (auto object : objects_) {
+      if (object) {
+        this->activate(object->index_);
+        object->do_reset();
+      }
+    }
+  }
+
+  void tick(uint64_t cycles) {
+    // evaluate events
+    auto& bucket = wheel_[cycles & WHEEL_MASK];
+    auto event = bucket.head;
+    bucket.head = nullptr;
+    bucket.tail = nullptr;
+    while (event) {
+      assert(event->cycles() == cycles);
+      auto next = event->next_;
+      event->fire();
+      event->release();
+      event = next;
+    }
+    // evaluate active components in creation order,
+    // re-reading the mask picks up objects woken up further down.
+    for (uint32_t w = 0, n = active_.size(); w < n; ++w) {
+      idle_[w] &= ~active_[w];
+      uint64_t mask = active_[w];
+      while (mask) {
+        uint32_t b = __builtin_ctzll(mask);
+        objects_[(w << 6) + b]->do_tick();
+        mask = active_[w] & (~uint64_t(1) << b);
+      }
+    }
+  }
+
+  bool tick_clocked() {
+    bool clocked = false;
+    for (uint32_t w = 0, n = active_.size(); w < n; ++w) {
+      uint64_t mask = active_[w] & clocked_[w];
+      while (mask) {
+        uint32_t b = __builtin_ctzll(mask);
+        idle_[w] &= ~(uint64_t(1) << b);
+        objects_[(w << 6) + b]->do_tick();
+        mask &= mask - 1;
+        clocked = true;
+      }
+    }
+    return clocked;
+  }
+
+  void skip(uint64_t cycles) {
+    for (uint32_t w = 0, n = active_.size(); w < n; ++w) {
+      uint64_t mask = active_[w] & ~clocked_[w];
+      while (mask) {
+        uint32_t b = __builtin_ctzll(mask);
+        objects_[(w << 6) + b]->do_skip(cycles);
+        mask &= mask - 1;
+      }
+    }
+  }
+
+  void tock() {
+    for (auto object : tocks_) {
+      object->do_tock();
+    }
+    tocks_.clear();
+  }
+
+  // no event is due this cycle and all active objects are idle
+  bool stalled(uint64_t cycles) const {
+    if (wheel_[cycles & WHEEL_MASK].head)
+      return false;
+    for (uint32_t w = 0, n = active_.size(); w < n; ++w) {
+      if (active_[w] & ~idle_[w])
+        return false;
+    }
+    return true;
+  }
+
+  uint64_t next_event(uint64_t cycles) const {
+    for (uint32_t i = 1; i < WHEEL_SIZE; ++i) {
+      auto event = wheel_[(cycles + i) & WHEEL_MASK].head;
+      if (event)
+        return event->cycles();
+    }
+    if (!overflow_.empty())
+      return overflow_.top().event->cycles();
+    return uint64_t(-1);
+  }
+
+  // move overflow events entering the wheel window
+  void refill(uint64_t cycles) {
+    while (!overflow_.empty()
+        && overflow_.top().event->cycles() < (cycles + WHEEL_SIZE)) {
+      this->append(overflow_.top().event);
+      overflow_.pop();
+    }
+  }
+
+  void clear_events() {
+    for (auto& bucket : wheel_) {
+      auto event = bucket.head;
+      while (event) {
+        auto next = event->next_;
+        event->release();
+        event = next;
+      }
+      bucket.head = nullptr;
+      bucket.tail = nullptr;
+    }
+    while (!overflow_.empty()) {
+      overflow_.top().event->release();
+      overflow_.pop();
+    }
+    overflow_order_ = 0;
+    for (auto& mailbox : outbox_) {
+      for (auto event : mailbox) {
+        event->release();
+      }
+      mailbox.clear();
+    }
+    has_mail_ = false;
+    tocks_.clear();
+  }
+
+  void append(SimEventBase* evt) {
+    auto& bucket = wheel_[evt->cycles() & WHEEL_MASK];
+    evt->next_ = nullptr;
+    if (bucket.tail) {
+      bucket.tail->next_ = evt;
+    } else {
+      bucket.head = evt;
+    }
+    bucket.tail = evt;
+  }
+
+  void enqueue(SimEventBase* evt, uint64_t cycles) {
+    // events due within the wheel window go straight into their bucket,
+    // farther ones wait in the overflow heap until the window reaches them.
+    if ((evt->cycles() - cycles) < WHEEL_SIZE) {
+      this->append(evt);
+    } else {
+      overflow_.push({evt, overflow_order_++});
+    }
+  }
+
+  uint32_t id_;
+  std::vector<SimObjectBase*> objects_;
+  std::vector<uint64_t> active_;
+  std::vector<uint64_t> idle_;
+  std::vector<uint64_t> clocked_;
+  std::vector<bucket_t> wheel_;
+  overflow_queue_t overflow_;
+  uint64_t overflow_order_;
+  std::vector<SimObjectBase*> tocks_;
+  std::vector<std::vector<SimEventBase*>> outbox_;
+  bool has_mail_;
+
+  friend class SimObjectBase;
+  friend class SimPlatform;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Owns the objects of one simulated device. Platforms are independent of each
+// other, several of them can be simulated concurrently from different threads.
 class SimPlatform {
 public:
-  static SimPlatform& instance() {
-    static SimPlatform s_inst;
-    return s_inst;
+  SimPlatform()
+    : context_(this)
+    , num_threads_(1)
+    , phase_(0)
+    , pending_(0)
+    , stop_(false)
+    , cycles_(0)
+  {
+    this->new_partition();
+  }
+
+  virtual ~SimPlatform() {
+    // pending events are not released here, their arenas may already be
+    // gone at exit; finalize() releases them explicitly.
+    this->stop_workers();
+  }
+
+  const SimContext& context() const {
+    return context_;
   }
 
   bool initialize() {
@@ -304,84 +687,276 @@ public:
   }
 
   void finalize() {
-    instance().clear();
+    this->clear();
+  }
+
+  // threads used to tick partitions, partitions are dealt round-robin
+  // and each cycle ends with a barrier; results do not depend on it.
+  void set_num_threads(uint32_t num_threads) {
+    this->stop_workers();
+    num_threads_ = std::max<uint32_t>(num_threads, 1);
+  }
+
+  uint32_t num_threads() const {
+    return num_threads_;
+  }
+
+  // objects created from here on form a new partition
+  void new_partition() {
+    this->stop_workers();
+    partitions_.emplace_back(new SimPartition(partitions_.size()));
+    for (auto& partition : partitions_) {
+      partition->outbox_.resize(partitions_.size());
+    }
   }
 
   template <typename Impl, typename... Args>
   typename SimObject<Impl>::Ptr create_object(Args&&... args) {
-    auto obj = std::make_shared<Impl>(SimContext{}, std::forward<Args>(args)...);
+    auto obj = std::make_shared<Impl>(context_, std::forward<Args>(args)...);
     objects_.push_back(obj);
+    partitions_.back()->add_object(obj.get());
     return obj;
   }
 
   void release_object(const SimObjectBase::Ptr& object) {
-    objects_.remove(object);
+    auto partition = object->partition_;
+    auto index = object->index_;
+    assert(partition->objects_.at(index) == object.get());
+    partition->deactivate(index);
+    partition->objects_.at(index) = nullptr;
+    objects_.erase(std::find(objects_.begin(), objects_.end(), object));
   }
 
-  template <typename Pkt>
-  void schedule(const typename SimCallEvent<Pkt>::Func& callback,
-                const Pkt& pkt, 
-                uint64_t delay) {    
+  template <typename Pkt, typename Func>
+  void schedule(const Func& callback, const Pkt& pkt, uint64_t delay) {
     assert(delay != 0);
-    auto evt = std::make_shared<SimCallEvent<Pkt>>(callback, pkt, cycles_ + delay);    
-    events_.emplace_back(evt);
+    auto evt = new SimCallEvent<Pkt, Func>(callback, pkt, cycles_ + delay);
+    auto partition = current();
+    this->post(evt, partition ? partition : partitions_.front().get());
   }
 
   void reset() {
-    events_.clear();
-    for (auto& object : objects_) {
-      object->do_reset();
+    active_scope_t scope(this);
+    for (auto& partition : partitions_) {
+      partition->reset();
     }
     cycles_ = 0;
   }
 
   void tick() {
-    // evaluate events
-    auto evt_it = events_.begin();
-    auto evt_it_end = events_.end();
-    while (evt_it != evt_it_end) {
-      auto& event = *evt_it;
-      if (cycles_ >= event->cycles()) {        
-        event->fire();
-        evt_it = events_.erase(evt_it);
-      } else {        
-        ++evt_it;
+    active_scope_t scope(this);
+    if (num_threads_ > 1 && partitions_.size() > 1) {
+      if (workers_.empty()) {
+        this->start_workers();
       }
+      // release the workers and wait for all of them at the barrier
+      pending_.store(workers_.size(), std::memory_order_relaxed);
+      phase_.fetch_add(1, std::memory_order_release);
+      this->tick_partitions(0, workers_.size() + 1);
+      spin_until([&]{ return 0 == pending_.load(std::memory_order_acquire); });
+    } else {
+      this->tick_partitions(0, 1);
     }
-    // evaluate components
-    for (auto& object : objects_) {
-      object->do_tick();
+    this->advance();
+  }
+
+  // advance the clock over cycles where every active object is idle and no
+  // event is due, only ticking clocked objects, then let the idle objects
+  // account for the skipped cycles. Returns the number of cycles skipped.
+  uint64_t fast_forward(uint64_t max_cycles = uint64_t(-1)) {
+    active_scope_t scope(this);
+    uint64_t start = cycles_;
+    while ((cycles_ - start) < max_cycles && this->stalled()) {
+      bool clocked = false;
+      for (auto& partition : partitions_) {
+        current() = partition.get();
+        clocked |= partition->tick_clocked();
+      }
+      current() = nullptr;
+      if (clocked) {
+        this->advance();
+      } else {
+        // nothing to tick, jump straight to the next event
+        auto next = this->next_event();
+        if (next == uint64_t(-1) && max_cycles == uint64_t(-1))
+          break;
+        cycles_ = std::min(next, start + max_cycles);
+        for (auto& partition : partitions_) {
+          partition->refill(cycles_);
+        }
+      }
     }
-    // advance clock    
-    ++cycles_;
+    uint64_t cycles = cycles_ - start;
+    if (cycles != 0) {
+      for (auto& partition : partitions_) {
+        partition->skip(cycles);
+      }
+    }
+    return cycles;
   }
 
   uint64_t cycles() const {
     return cycles_;
   }
 
+  // cycles of the platform being evaluated by the calling thread, for tracing
+  static uint64_t active_cycles() {
+    auto platform = active();
+    return platform ? platform->cycles_ : 0;
+  }
+
 private:
 
-  SimPlatform() : cycles_(0) {}
-
-  virtual ~SimPlatform() {
-    this->clear();
-  }
+  SimPlatform(const SimPlatform&) = delete;
+  SimPlatform& operator=(const SimPlatform&) = delete;
 
   void clear() {
+    this->stop_workers();
+    for (auto& partition : partitions_) {
+      partition->clear_events();
+    }
+    partitions_.clear();
     objects_.clear();
-    events_.clear();
+    this->new_partition();
+  }
+
+  // partition being evaluated by the calling thread
+  static SimPartition*& current() {
+    static thread_local SimPartition* s_current = nullptr;
+    return s_current;
+  }
+
+  // platform being evaluated by the calling thread
+  static SimPlatform*& active() {
+    static thread_local SimPlatform* s_active = nullptr;
+    return s_active;
+  }
+
+  struct active_scope_t {
+    SimPlatform* saved;
+    active_scope_t(SimPlatform* platform) : saved(active()) {
+      active() = platform;
+    }
+    ~active_scope_t() {
+      active() = saved;
+    }
+  };
+
+  template <typename Pred>
+  static void spin_until(const Pred& pred) {
+    for (uint32_t i = 0; !pred(); ++i) {
+      if (i >= 1024) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void tick_partitions(uint32_t tid, uint32_t num_threads) {
+    for (uint32_t i = tid, n = partitions_.size(); i < n; i += num_threads) {
+      current() = partitions_[i].get();
+      partitions_[i]->tick(cycles_);
+    }
+    current() = nullptr;
+  }
+
+  // close the cycle: run the tocks and deliver the mailboxes in partition
+  // order, then move the clock forward.
+  void advance() {
+    for (auto& src : partitions_) {
+      if (!src->tocks_.empty()) {
+        current() = src.get();
+        src->tock();
+        current() = nullptr;
+      }
+      if (src->has_mail_) {
+        for (auto& dst : partitions_) {
+          auto& mailbox = src->outbox_[dst->id_];
+          for (auto event : mailbox) {
+            dst->enqueue(event, cycles_);
+          }
+          mailbox.clear();
+        }
+        src->has_mail_ = false;
+      }
+    }
+    ++cycles_;
+    for (auto& partition : partitions_) {
+      partition->refill(cycles_);
+    }
+  }
+
+  bool stalled() const {
+    for (auto& partition : partitions_) {
+      if (!partition->stalled(cycles_))
+        return false;
+    }
+    return true;
+  }
+
+  uint64_t next_event() const {
+    uint64_t next = uint64_t(-1);
+    for (auto& partition : partitions_) {
+      next = std::min(next, partition->next_event(cycles_));
+    }
+    return next;
+  }
+
+  void post(SimEventBase* evt, SimPartition* dst) {
+    auto src = current();
+    if (nullptr == src || src == dst) {
+      dst->enqueue(evt, cycles_);
+    } else {
+      src->outbox_[dst->id_].push_back(evt);
+      src->has_mail_ = true;
+    }
   }
 
   template <typename Pkt>
   void schedule(const SimPort<Pkt>* port, const Pkt& pkt, uint64_t delay) {
     assert(delay != 0);
-    auto evt = SimEventBase::Ptr(new SimPortEvent<Pkt>(port, pkt, cycles_ + delay));
-    events_.emplace_back(evt);
+    auto evt = new SimPortEvent<Pkt>(port, pkt, cycles_ + delay);
+    this->post(evt, port->module()->partition_);
+  }
+
+  void start_workers() {
+    uint32_t num_threads = std::min<uint32_t>(num_threads_, partitions_.size());
+    uint64_t start = phase_.load(std::memory_order_relaxed);
+    stop_ = false;
+    for (uint32_t tid = 1; tid < num_threads; ++tid) {
+      workers_.emplace_back([this, tid, num_threads, start]() {
+        active() = this;
+        uint64_t phase = start;
+        for (;;) {
+          spin_until([&]{ return phase != phase_.load(std::memory_order_acquire); });
+          ++phase;
+          if (stop_)
+            break;
+          this->tick_partitions(tid, num_threads);
+          pending_.fetch_sub(1, std::memory_order_release);
+        }
+      });
+    }
   }
 
-  std::list<SimObjectBase::Ptr> objects_;
-  std::list<SimEventBase::Ptr> events_;
+  void stop_workers() {
+    if (workers_.empty())
+      return;
+    stop_ = true;
+    phase_.fetch_add(1, std::memory_order_release);
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+  }
+
+  SimContext context_;
+  std::vector<SimObjectBase::Ptr> objects_;
+  std::vector<std::unique_ptr<SimPartition>> partitions_;
+  std::vector<std::thread> workers_;
+  uint32_t num_threads_;
+  std::atomic<uint64_t> phase_;
+  std::atomic<uint32_t> pending_;
+  bool stop_;
   uint64_t cycles_;
 
   template <typename U> friend class SimPort;
@@ -390,14 +965,34 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-inline SimObjectBase::SimObjectBase(const SimContext&, const char* name) 
+inline SimObjectBase::SimObjectBase(const SimContext& ctx, const char* name) 
   : name_(name) 
+  , platform_(ctx.platform())
+  , partition_(nullptr)
+  , index_(0)
+  , clocked_(false)
 {}
 
+inline void SimObjectBase::wakeup() {
+  partition_->activate(index_);
+}
+
+inline void SimObjectBase::sleep() {
+  partition_->deactivate(index_);
+}
+
+inline void SimObjectBase::idle() {
+  partition_->set_idle(index_);
+}
+
+inline void SimObjectBase::request_tock() {
+  partition_->tocks_.push_back(this);
+}
+
 template <typename Impl>
 template <typename... Args>
-typename SimObject<Impl>::Ptr SimObject<Impl>::Create(Args&&... args) {
-  return SimPlatform::instance().create_object<Impl>(std::forward<Args>(args)...);
+typename SimObject<Impl>::Ptr SimObject<Impl>::Create(const SimContext& ctx, Args&&... args) {
+  return ctx.platform()->create_object<Impl>(std::forward<Args>(args)...);
 }
 
 template <typename Pkt>
@@ -405,6 +1000,31 @@ void SimPort<Pkt>::push(const Pkt& pkt, uint64_t delay) const {
   if (peer_ && !tx_cb_) {
     reinterpret_cast<const SimPort<Pkt>*>(peer_)->push(pkt, delay);    
   } else {
-    SimPlatform::instance().schedule(this, pkt, delay);
+    if (capacity_ && !peer_) {
+      assert(!this->full());
+      ++pending_;
+    }
+    module_->platform().schedule(this, pkt, delay);
   } 
 }
+
+template <typename Pkt>
+void SimPort<Pkt>::deliver(const Pkt& data, uint64_t cycles) {
+  if (tx_cb_) {
+    tx_cb_(data, cycles);
+  }
+  if (peer_) {
+    peer_->deliver(data, cycles);
+  } else {
+    if (size_ == queue_.size()) {
+      // fixed-size ports should never overflow
+      assert(0 == capacity_);
+      this->grow();
+    }
+    auto& entry = queue_[(head_ + size_) & (queue_.size() - 1)];
+    entry.pkt = data;
+    entry.cycles = cycles;
+    ++size_;
+    listener_->wakeup();
+  }
+}
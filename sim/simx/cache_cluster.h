@@ -48,7 +48,7 @@ public:
 		std::vector<MemSwitch::Ptr> input_arbs(num_inputs);
 		for (uint32_t j = 0; j < num_inputs; ++j) {
 			snprintf(sname, 100, "%s-input-arb%d", name, j);
-			input_arbs.at(j) = MemSwitch::Create(sname, ArbiterType::RoundRobin, num_requests, cache_config.num_inputs);
+			input_arbs.at(j) = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, num_requests, cache_config.num_inputs);
 			for (uint32_t i = 0; i < num_requests; ++i) {
 				this->CoreReqPorts.at(j).at(i).bind(&input_arbs.at(j)->ReqIn.at(i));
 				input_arbs.at(j)->RspIn.at(i).bind(&this->CoreRspPorts.at(j).at(i));
@@ -58,7 +58,7 @@ public:
 		std::vector<MemSwitch::Ptr> mem_arbs(cache_config.num_inputs);
 		for (uint32_t i = 0; i < cache_config.num_inputs; ++i) {
 			snprintf(sname, 100, "%s-mem-arb%d", name, i);
-			mem_arbs.at(i) = MemSwitch::Create(sname, ArbiterType::RoundRobin, num_inputs, num_caches);
+			mem_arbs.at(i) = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, num_inputs, num_caches);
 			for (uint32_t j = 0; j < num_inputs; ++j) {
 				input_arbs.at(j)->ReqOut.at(i).bind(&mem_arbs.at(i)->ReqIn.at(j));
 				mem_arbs.at(i)->RspIn.at(j).bind(&input_arbs.at(j)->RspOut.at(i));
@@ -66,11 +66,11 @@ public:
 		}
 
 		snprintf(sname, 100, "%s-cache-arb", name);
-		auto cache_arb = MemSwitch::Create(sname, ArbiterType::RoundRobin, num_caches, 1);
+		auto cache_arb = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, num_caches, 1);
 
 		for (uint32_t i = 0; i < num_caches; ++i) {
 			snprintf(sname, 100, "%s-cache%d", name, i);
-			caches_.at(i) = CacheSim::Create(sname, cache_config2);
+			caches_.at(i) = CacheSim::Create(ctx, sname, cache_config2);
 
 			for (uint32_t j = 0; j < cache_config.num_inputs; ++j) {
 				mem_arbs.at(j)->ReqOut.at(i).bind(&caches_.at(i)->CoreReqPorts.at(j));
@@ -89,7 +89,28 @@ public:
 
 	void reset() {}
 	
-	void tick() {}
+	void tick() {
+		this->sleep();
+	}
+
+	// warm the cache serving the given input, the mem arbiters map
+	// consecutive inputs to the same cache.
+	bool warm(uint32_t input, uint64_t addr, bool write) {
+		uint32_t lg_inputs_per_cache = log2ceil(CoreReqPorts.size() / caches_.size());
+		return caches_.at(input >> lg_inputs_per_cache)->warm(addr, write);
+	}
+
+	void save(std::ostream& os) const {
+		for (auto cache : caches_) {
+			cache->save(os);
+		}
+	}
+
+	void load(std::istream& is) {
+		for (auto cache : caches_) {
+			cache->load(is);
+		}
+	}
 
 	CacheSim::PerfStats perf_stats() const {
 		CacheSim::PerfStats perf;
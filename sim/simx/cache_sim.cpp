@@ -15,6 +15,7 @@
 #include "debug.h"
 #include "types.h"
 #include <util.h>
+#include <serialize.h>
 #include <unordered_map>
 #include <vector>
 #include <list>
@@ -22,6 +23,9 @@
 
 using namespace vortex;
 
+// pending atomics tracked per bank before completed ones are swept
+#define AMO_LINES_SWEEP 64
+
 struct params_t {
 	uint32_t sets_per_bank;
 	uint32_t lines_per_set;
@@ -156,6 +160,7 @@ struct bank_req_t {
 	uint64_t uuid;
 	ReqType  type;
 	bool     write;
+	bool     amo;
 
 	bank_req_t(uint32_t num_ports)
 		: ports(num_ports)
@@ -166,6 +171,7 @@ struct bank_req_t {
 			port.clear();
 		}
 		type = ReqType::None;
+		amo  = false;
 	}
 };
 
@@ -239,6 +245,14 @@ public:
 		return root_entry;
 	}
 
+	bool has_replay() const {
+		for (auto& entry : entries_) {
+			if (entry.bank_req.type == bank_req_t::Replay)
+				return true;
+		}
+		return false;
+	}
+
 	bool pop(bank_req_t* out) {
 		for (auto& entry : entries_) {
 			if (entry.bank_req.type == bank_req_t::Replay) {
@@ -262,18 +276,50 @@ public:
 struct bank_t {
 	std::vector<set_t> sets;
 	MSHR               mshr;
+	// atomic unit: release cycle of the lines with an atomic in flight
+	std::unordered_map<uint64_t, uint64_t> amo_lines;
+	uint64_t           amo_ready;
 
 	bank_t(const CacheSim::Config& config,
 				 const params_t& params)
 		: sets(params.sets_per_bank, params.lines_per_set)
 		, mshr(config.mshr_size, config.ports_per_bank)
+		, amo_ready(0)
 	{}
 
+	bool amo_busy(uint64_t line_addr, uint64_t cycle) {
+		auto it = amo_lines.find(line_addr);
+		if (it == amo_lines.end())
+			return false;
+		if (cycle < it->second)
+			return true;
+		amo_lines.erase(it);
+		return false;
+	}
+
+	void amo_lock(uint64_t line_addr, uint64_t cycle, uint32_t interval) {
+		// drop the lines whose atomics have completed
+		if (amo_lines.size() >= AMO_LINES_SWEEP) {
+			for (auto it = amo_lines.begin(); it != amo_lines.end();) {
+				if (cycle >= it->second) {
+					it = amo_lines.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+		// locked until the atomic unit performs the update
+		amo_lines[line_addr] = UINT64_MAX;
+		amo_ready = cycle + interval;
+	}
+
 	void clear() {
 		for (auto& set : sets) {
 			set.clear();
 		}
 		mshr.clear();
+		amo_lines.clear();
+		amo_ready = 0;
 	}
 };
 
@@ -297,7 +343,7 @@ private:
 	uint64_t pending_fill_reqs_;
 
 public:
-	Impl(CacheSim* simobject, const Config& config)
+	Impl(CacheSim* simobject, const SimContext& ctx, const Config& config)
 		: simobject_(simobject)
 		, config_(config)
 		, params_(config)
@@ -310,7 +356,7 @@ public:
 		snprintf(sname, 100, "%s-bypass-arb", simobject->name().c_str());
 
 		if (config_.bypass) {
-			bypass_switch_ = MemSwitch::Create(sname, ArbiterType::RoundRobin, config_.num_inputs);
+			bypass_switch_ = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, config_.num_inputs);
 			for (uint32_t i = 0; i < config_.num_inputs; ++i) {
 				simobject->CoreReqPorts.at(i).bind(&bypass_switch_->ReqIn.at(i));
 				bypass_switch_->RspIn.at(i).bind(&simobject->CoreRspPorts.at(i));
@@ -320,13 +366,16 @@ public:
 			return;
 		}
 
-		bypass_switch_ = MemSwitch::Create(sname, ArbiterType::Priority, 2);
+		bypass_switch_ = MemSwitch::Create(ctx, sname, ArbiterType::Priority, 2);
 		bypass_switch_->ReqOut.at(0).bind(&simobject->MemReqPort);
 		simobject->MemRspPort.bind(&bypass_switch_->RspOut.at(0));
 
+		// bypass responses are drained directly from the switch port
+		bypass_switch_->RspIn.at(1).listener(simobject);
+
 		if (config.B != 0) {
 			snprintf(sname, 100, "%s-bank-arb", simobject->name().c_str());
-			bank_switch_ = MemSwitch::Create(sname, ArbiterType::RoundRobin, (1 << config.B));
+			bank_switch_ = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, (1 << config.B));
 			for (uint32_t i = 0, n = (1 << config.B); i < n; ++i) {
 				mem_req_ports_.at(i).bind(&bank_switch_->ReqIn.at(i));
 				bank_switch_->RspIn.at(i).bind(&mem_rsp_ports_.at(i));
@@ -356,8 +405,10 @@ public:
 	}
 
   void tick() {
-		if (config_.bypass)
+		if (config_.bypass) {
+			simobject_->sleep();
 			return;
+		}
 
 		// wait on cache initialization cycles
 		if (init_cycles_ != 0) {
@@ -423,6 +474,16 @@ public:
 				continue;
 			}
 
+			bool is_amo = (core_req.amo != AmoType::None);
+
+			// atomics performed downstream invalidate the local copy
+			if (is_amo && config_.amo_policy == AmoPolicy::Forward) {
+				this->invalidate(core_req.addr);
+				this->processBypassRequest(core_req, req_id);
+				core_req_port.pop();
+				continue;
+			}
+
 			auto bank_id = params_.addr_bank_id(core_req.addr);
 			auto& bank = banks_.at(bank_id);
 			auto& pipeline_req = pipeline_reqs_.at(bank_id);
@@ -435,6 +496,19 @@ public:
 			auto tag     = params_.addr_tag(core_req.addr);
 			auto port_id = req_id % config_.ports_per_bank;
 
+			// the atomic unit accepts one request per interval
+			// and serializes the updates to a line
+			bool amo_exec = is_amo && (config_.amo_policy == AmoPolicy::Execute);
+			if (amo_exec) {
+				auto cycle = simobject_->platform().cycles();
+				auto line_addr = params_.mem_addr(bank_id, set_id, tag);
+				if (cycle < bank.amo_ready
+				 || bank.amo_busy(line_addr, cycle)) {
+					++perf_stats_.amo_stalls;
+					continue;
+				}
+			}
+
 			// check MSHR capacity
 			if ((!core_req.write || !config_.write_through)
 		   && bank.mshr.full()) {
@@ -445,7 +519,9 @@ public:
 			// check bank conflicts
 			if (pipeline_req.type == bank_req_t::Core) {
 				// check port conflict
-				if (pipeline_req.write != core_req.write
+				if (amo_exec
+				 || pipeline_req.amo
+				 || pipeline_req.write != core_req.write
 				 || pipeline_req.set_id != set_id
 				 || pipeline_req.tag != tag
 				 || pipeline_req.ports.at(port_id).valid) {
@@ -455,31 +531,148 @@ public:
 				// extend request ports
 				pipeline_req.ports.at(port_id) = bank_req_port_t{req_id, core_req.tag, true};
 			} else {
-				// schedule new request
-				bank_req_t bank_req(config_.ports_per_bank);
-				bank_req.ports.at(port_id) = bank_req_port_t{req_id, core_req.tag, true};
-				bank_req.tag   = tag;
-				bank_req.set_id = set_id;
-				bank_req.cid   = core_req.cid;
-				bank_req.uuid  = core_req.uuid;
-				bank_req.type  = bank_req_t::Core;
-				bank_req.write = core_req.write;
-				pipeline_req   = bank_req;
+				// schedule new request, the idle slot has no valid ports
+				pipeline_req.ports.at(port_id) = bank_req_port_t{req_id, core_req.tag, true};
+				pipeline_req.tag    = tag;
+				pipeline_req.set_id = set_id;
+				pipeline_req.cid    = core_req.cid;
+				pipeline_req.uuid   = core_req.uuid;
+				pipeline_req.type   = bank_req_t::Core;
+				pipeline_req.write  = core_req.write;
+				pipeline_req.amo    = amo_exec;
 			}
 
-			if (core_req.write)
+			if (amo_exec) {
+				auto line_addr = params_.mem_addr(bank_id, set_id, tag);
+				bank.amo_lock(line_addr, simobject_->platform().cycles(), config_.amo_interval);
+				++perf_stats_.amos;
+			} else if (core_req.write) {
 				++perf_stats_.writes;
-			else
+			} else {
 				++perf_stats_.reads;
+			}
 
 			// remove request
 			DT(3, simobject_->name() << "-core-" << core_req);
 			auto time = core_req_port.pop();
-			perf_stats_.pipeline_stalls += (SimPlatform::instance().cycles() - time);
+			perf_stats_.pipeline_stalls += (simobject_->platform().cycles() - time);
 		}
 
 		// process active request
 		this->processBankRequests();
+
+		// sleep until new requests or responses arrive,
+		// pending fills only advance the memory latency meanwhile.
+		if (this->waiting()) {
+			if (0 == pending_fill_reqs_) {
+				simobject_->sleep();
+			} else {
+				simobject_->idle();
+			}
+		}
+	}
+
+	void skip(uint64_t cycles) {
+		perf_stats_.mem_latency += pending_fill_reqs_ * cycles;
+	}
+
+	bool warm(uint64_t addr, bool write) {
+		if (config_.bypass)
+			return true;
+
+		// a warm cache is past its initialization
+		init_cycles_ = 0;
+
+		auto bank_id = params_.addr_bank_id(addr);
+		auto set_id  = params_.addr_set_id(addr);
+		auto tag     = params_.addr_tag(addr);
+		auto& set    = banks_.at(bank_id).sets.at(set_id);
+
+		int32_t hit_line_id  = -1;
+		int32_t free_line_id = -1;
+		int32_t repl_line_id = 0;
+		uint32_t max_cnt = 0;
+
+		// same lookup and replacement as processBankRequests()
+		for (uint32_t i = 0, n = set.lines.size(); i < n; ++i) {
+			auto& line = set.lines.at(i);
+			if (max_cnt < line.lru_ctr) {
+				max_cnt = line.lru_ctr;
+				repl_line_id = i;
+			}
+			if (line.valid) {
+				if (line.tag == tag) {
+					hit_line_id = i;
+					line.lru_ctr = 0;
+				} else {
+					++line.lru_ctr;
+				}
+			} else {
+				free_line_id = i;
+			}
+		}
+
+		if (hit_line_id != -1) {
+			if (write && !config_.write_through) {
+				set.lines.at(hit_line_id).dirty = true;
+			}
+			return write && config_.write_through;
+		}
+
+		// write-through caches do not allocate on write misses
+		if (write && config_.write_through)
+			return true;
+
+		auto& line = set.lines.at((free_line_id != -1) ? free_line_id : repl_line_id);
+		line.valid = true;
+		line.dirty = false;
+		line.tag   = tag;
+		return true;
+	}
+
+	void save(std::ostream& os) const {
+		serialize(os, uint32_t(banks_.size()));
+		serialize(os, params_.sets_per_bank);
+		serialize(os, params_.lines_per_set);
+		serialize(os, init_cycles_);
+		for (auto& bank : banks_) {
+			// only quiescent caches are saved
+			assert(bank.mshr.empty());
+			for (auto& set : bank.sets) {
+				for (auto& line : set.lines) {
+					serialize(os, line.tag);
+					serialize(os, line.lru_ctr);
+					serialize(os, line.valid);
+					serialize(os, line.dirty);
+				}
+			}
+		}
+	}
+
+	void load(std::istream& is) {
+		uint32_t num_banks = 0, sets_per_bank = 0, lines_per_set = 0;
+		deserialize(is, num_banks);
+		deserialize(is, sets_per_bank);
+		deserialize(is, lines_per_set);
+		deserialize(is, init_cycles_);
+		if (!is)
+			return;
+		if (num_banks != banks_.size()
+		 || sets_per_bank != params_.sets_per_bank
+		 || lines_per_set != params_.lines_per_set) {
+			std::cout << "Error: checkpoint cache geometry mismatch in " << simobject_->name() << std::endl;
+			std::abort();
+		}
+		for (auto& bank : banks_) {
+			for (auto& set : bank.sets) {
+				for (auto& line : set.lines) {
+					deserialize(is, line.tag);
+					deserialize(is, line.lru_ctr);
+					deserialize(is, line.valid);
+					deserialize(is, line.dirty);
+				}
+			}
+		}
 	}
 
 	const PerfStats& perf_stats() const {
@@ -488,6 +681,24 @@ public:
 
 private:
 
+	bool waiting() const {
+		if (!bypass_switch_->RspIn.at(1).empty())
+			return false;
+		for (auto& bank : banks_) {
+			if (bank.mshr.has_replay())
+				return false;
+		}
+		for (auto& mem_rsp_port : mem_rsp_ports_) {
+			if (!mem_rsp_port.empty())
+				return false;
+		}
+		for (auto& core_req_port : simobject_->CoreReqPorts) {
+			if (!core_req_port.empty())
+				return false;
+		}
+		return true;
+	}
+
 	void processBypassResponse(const MemRsp& mem_rsp) {
 		uint32_t req_id = mem_rsp.tag & ((1 << params_.log2_num_inputs)-1);
 		uint64_t tag = mem_rsp.tag >> params_.log2_num_inputs;
@@ -513,10 +724,54 @@ private:
 		}
 	}
 
+	void invalidate(uint64_t addr) {
+		auto bank_id = params_.addr_bank_id(addr);
+		auto set_id  = params_.addr_set_id(addr);
+		auto tag     = params_.addr_tag(addr);
+		for (auto& line : banks_.at(bank_id).sets.at(set_id).lines) {
+			if (line.valid && line.tag == tag) {
+				line.clear();
+			}
+		}
+	}
+
+	void processAmoRequest(uint32_t bank_id, const bank_req_t& bank_req) {
+		auto& bank = banks_.at(bank_id);
+		auto line_addr = params_.mem_addr(bank_id, bank_req.set_id, bank_req.tag);
+		auto done = simobject_->platform().cycles() + config_.amo_latency;
+		bank.amo_lines[line_addr] = done;
+
+		// write the updated line back
+		if (config_.write_through) {
+			MemReq mem_req;
+			mem_req.addr  = line_addr;
+			mem_req.write = true;
+			mem_req.cid   = bank_req.cid;
+			mem_req.uuid  = bank_req.uuid;
+			mem_req_ports_.at(bank_id).push(mem_req, config_.amo_latency);
+			DT(3, simobject_->name() << "-dram-" << mem_req);
+		} else {
+			for (auto& line : bank.sets.at(bank_req.set_id).lines) {
+				if (line.valid && line.tag == bank_req.tag) {
+					line.dirty = true;
+				}
+			}
+		}
+
+		// send core response
+		for (auto& info : bank_req.ports) {
+			if (!info.valid)
+				continue;
+			MemRsp core_rsp{info.req_tag, bank_req.cid, bank_req.uuid};
+			simobject_->CoreRspPorts.at(info.req_id).push(core_rsp, config_.latency + config_.amo_latency);
+			DT(3, simobject_->name() << "-core-" << core_rsp);
+		}
+	}
+
 	void processBankRequests() {
 		for (uint32_t bank_id = 0, n = (1 << config_.B); bank_id < n; ++bank_id) {
 			auto& bank = banks_.at(bank_id);
-			auto pipeline_req = pipeline_reqs_.at(bank_id);
+			auto& pipeline_req = pipeline_reqs_.at(bank_id);
 
 			switch (pipeline_req.type) {
 			case bank_req_t::None:
@@ -532,6 +787,10 @@ private:
 				--pending_fill_reqs_;
 			} break;
 			case bank_req_t::Replay: {
+				if (pipeline_req.amo) {
+					this->processAmoRequest(bank_id, pipeline_req);
+					break;
+				}
 				// send core response
 				if (!pipeline_req.write || config_.write_reponse) {
 					for (auto& info : pipeline_req.ports) {
@@ -572,6 +831,10 @@ private:
 
 				if (hit_line_id != -1) {
 					// Hit handling
+					if (pipeline_req.amo) {
+						this->processAmoRequest(bank_id, pipeline_req);
+						break;
+					}
 					if (pipeline_req.write) {
 						// handle write has_hit
 						auto& hit_line = set.lines.at(hit_line_id);
@@ -678,7 +941,7 @@ CacheSim::CacheSim(const SimContext& ctx, const char* name, const Config& config
 	, CoreRspPorts(config.num_inputs, this)
 	, MemReqPort(this)
 	, MemRspPort(this)
-	, impl_(new Impl(this, config))
+	, impl_(new Impl(this, ctx, config))
 {}
 
 CacheSim::~CacheSim() {
@@ -693,6 +956,22 @@ void CacheSim::tick() {
   impl_->tick();
 }
 
+void CacheSim::skip(uint64_t cycles) {
+  impl_->skip(cycles);
+}
+
+bool CacheSim::warm(uint64_t addr, bool write) {
+  return impl_->warm(addr, write);
+}
+
+void CacheSim::save(std::ostream& os) const {
+  impl_->save(os);
+}
+
+void CacheSim::load(std::istream& is) {
+  impl_->load(is);
+}
+
 const CacheSim::PerfStats& CacheSim::perf_stats() const {
   return impl_->perf_stats();
 }
\ No newline at end of file
@@ -20,6 +20,13 @@ namespace vortex {
 
 class CacheSim : public SimObject<CacheSim> {
 public:
+	// handling of atomic requests
+	enum class AmoPolicy {
+		Read,    // timed as reads
+		Forward, // sent to the next level
+		Execute  // performed by the bank's atomic unit
+	};
+
 	struct Config {
 		bool    bypass;         // cache bypass
 		uint8_t C;              // log2 cache size
@@ -34,6 +41,9 @@ public:
 		bool    write_reponse;  // enable write response
 		uint16_t mshr_size;     // MSHR buffer size
 		uint8_t latency;        // pipeline latency
+		AmoPolicy amo_policy;   // atomic requests handling
+		uint8_t amo_latency;    // atomic unit latency
+		uint8_t amo_interval;   // cycles between atomics issued to a bank
 	};
 	
 	struct PerfStats {
@@ -46,6 +56,8 @@ public:
 		uint64_t bank_stalls;
 		uint64_t mshr_stalls;
 		uint64_t mem_latency;
+		uint64_t amos;
+		uint64_t amo_stalls;
 
 		PerfStats() 
 			: reads(0)
@@ -57,6 +69,8 @@ public:
 			, bank_stalls(0)
 			, mshr_stalls(0)
 			, mem_latency(0)
+			, amos(0)
+			, amo_stalls(0)
 		{}
 
 		PerfStats& operator+=(const PerfStats& rhs) {
@@ -69,6 +83,8 @@ public:
 			this->bank_stalls += rhs.bank_stalls;
 			this->mshr_stalls += rhs.mshr_stalls;
 			this->mem_latency += rhs.mem_latency;
+			this->amos += rhs.amos;
+			this->amo_stalls += rhs.amo_stalls;
 			return *this;
 		}
 	};
@@ -85,6 +101,17 @@ public:
 	
 	void tick();
 
+	void skip(uint64_t cycles);
+
+	// update the tags without timing or stats, used to warm the cache ahead
+	// of a detailed region. Returns true when the access reaches memory.
+	bool warm(uint64_t addr, bool write);
+
+	// checkpoint the tag arrays
+	void save(std::ostream& os) const;
+
+	void load(std::istream& is);
+
 	const PerfStats& perf_stats() const;
 	
 private:
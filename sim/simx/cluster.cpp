@@ -12,6 +12,8 @@
 // limitations under the License.
 
 #include "cluster.h"
+#include "processor_impl.h"
+#include <serialize.h>
 
 using namespace vortex;
 
@@ -33,17 +35,40 @@ Cluster::Cluster(const SimContext& ctx,
 
   uint32_t sockets_per_cluster = sockets_.size();
 
+  // Create l2cache, ahead of the cores so that it ticks before them
+  
+  snprintf(sname, 100, "cluster%d-l2cache", cluster_id);
+  l2cache_ = CacheSim::Create(ctx, sname, CacheSim::Config{
+    !L2_ENABLED,
+    log2ceil(L2_CACHE_SIZE),// C
+    log2ceil(MEM_BLOCK_SIZE),// L
+    log2ceil(L1_LINE_SIZE), // W
+    log2ceil(L2_NUM_WAYS),  // A
+    log2ceil(L2_NUM_BANKS), // B
+    XLEN,                   // address bits  
+    1,                      // number of ports
+    2,                      // request size 
+    true,                   // write-through
+    false,                  // write response
+    L2_MSHR_SIZE,           // mshr size
+    2,                      // pipeline latency
+    (AMO_CACHE_LEVEL == 2) ? CacheSim::AmoPolicy::Execute :
+      (AMO_CACHE_LEVEL ? CacheSim::AmoPolicy::Forward : CacheSim::AmoPolicy::Read), // atomics
+    AMO_LATENCY,            // atomic unit latency
+    AMO_INTERVAL,           // atomic unit interval
+  });
+
   // create sockets
 
   snprintf(sname, 100, "cluster%d-icache-arb", cluster_id);
-  auto icache_switch = MemSwitch::Create(sname, ArbiterType::RoundRobin, sockets_per_cluster);
+  auto icache_switch = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, sockets_per_cluster);
 
   snprintf(sname, 100, "cluster%d-dcache-arb", cluster_id);
-  auto dcache_switch = MemSwitch::Create(sname, ArbiterType::RoundRobin, sockets_per_cluster);
+  auto dcache_switch = MemSwitch::Create(ctx, sname, ArbiterType::RoundRobin, sockets_per_cluster);
 
   for (uint32_t i = 0; i < sockets_per_cluster; ++i) {
     uint32_t socket_id = cluster_id * sockets_per_cluster + i;
-    auto socket = Socket::Create(socket_id, 
+    auto socket = Socket::Create(ctx, socket_id, 
                                  this, 
                                  arch, 
                                  dcrs);
@@ -57,25 +82,6 @@ Cluster::Cluster(const SimContext& ctx,
     sockets_.at(i) = socket;
   }
 
-  // Create l2cache
-  
-  snprintf(sname, 100, "cluster%d-l2cache", cluster_id);
-  l2cache_ = CacheSim::Create(sname, CacheSim::Config{
-    !L2_ENABLED,
-    log2ceil(L2_CACHE_SIZE),// C
-    log2ceil(MEM_BLOCK_SIZE),// L
-    log2ceil(L1_LINE_SIZE), // W
-    log2ceil(L2_NUM_WAYS),  // A
-    log2ceil(L2_NUM_BANKS), // B
-    XLEN,                   // address bits  
-    1,                      // number of ports
-    2,                      // request size 
-    true,                   // write-through
-    false,                  // write response
-    L2_MSHR_SIZE,           // mshr size
-    2,                      // pipeline latency
-  });
-
   l2cache_->MemReqPort.bind(&this->mem_req_port);
   this->mem_rsp_port.bind(&l2cache_->MemRspPort);
 
@@ -97,7 +103,7 @@ void Cluster::reset() {
 }
 
 void Cluster::tick() {
-  //--
+  this->sleep();
 }
 
 void Cluster::attach_ram(RAM* ram) {
@@ -114,6 +120,46 @@ bool Cluster::running() const {
   return false;
 }
 
+uint32_t Cluster::step_functional() {
+  uint32_t num_instrs = 0;
+  for (auto& socket : sockets_) {
+    num_instrs += socket->step_functional();
+  }
+  return num_instrs;
+}
+
+void Cluster::warm_caches() {
+  for (auto& socket : sockets_) {
+    socket->warm_caches();
+  }
+}
+
+void Cluster::warm(uint64_t addr, bool write) {
+  if (l2cache_->warm(addr, write)) {
+    processor_->warm(addr, write);
+  }
+}
+
+void Cluster::save(std::ostream& os, bool caches) const {
+  serialize(os, barriers_);
+  for (auto& socket : sockets_) {
+    socket->save(os, caches);
+  }
+  if (caches) {
+    l2cache_->save(os);
+  }
+}
+
+void Cluster::load(std::istream& is, bool caches) {
+  deserialize(is, barriers_);
+  for (auto& socket : sockets_) {
+    socket->load(is, caches);
+  }
+  if (caches) {
+    l2cache_->load(is);
+  }
+}
+
 int Cluster::get_exitcode() const {
   int exitcode = 0;
   for (auto& socket : sockets_) {
@@ -51,6 +51,10 @@ public:
     return processor_;
   }
 
+  const std::vector<Socket::Ptr>& sockets() const {
+    return sockets_;
+  }
+
   void reset();
 
   void tick();
@@ -59,6 +63,16 @@ public:
 
   bool running() const;
 
+  uint32_t step_functional();
+
+  void warm_caches();
+
+  void warm(uint64_t addr, bool write);
+
+  void save(std::ostream& os, bool caches) const;
+
+  void load(std::istream& is, bool caches);
+
   int get_exitcode() const;  
 
   void barrier(uint32_t bar_id, uint32_t count, uint32_t core_id);
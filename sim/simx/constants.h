@@ -25,6 +25,54 @@
 #define MEMORY_BANKS 2
 #endif
 
+// decoded instructions cached per core (power of two)
+#ifndef DECODE_CACHE_SIZE
+#define DECODE_CACHE_SIZE 4096
+#endif
+
+// cache level performing the atomics: 0 times them as reads through the
+// caches, 2 or 3 executes them at the L2 or L3 banks (memory if disabled).
+#ifndef AMO_CACHE_LEVEL
+#define AMO_CACHE_LEVEL 0
+#endif
+
+#if (AMO_CACHE_LEVEL != 0 && AMO_CACHE_LEVEL != 2 && AMO_CACHE_LEVEL != 3)
+#error "AMO_CACHE_LEVEL must be 0, 2 or 3"
+#endif
+
+#ifndef AMO_LATENCY
+#define AMO_LATENCY 2
+#endif
+
+// cycles between atomics issued to a cache bank
+#ifndef AMO_INTERVAL
+#define AMO_INTERVAL 1
+#endif
+
+// warp groups of the two-level warp scheduler
+#ifndef WARP_SCHED_GROUPS
+#define WARP_SCHED_GROUPS 2
+#endif
+
+// pipeline port depths (power of two, 0 is unbounded)
+#ifndef OPERAND_IPORT_SIZE
+#define OPERAND_IPORT_SIZE 2
+#endif
+
+#ifndef OPERAND_OPORT_SIZE
+#define OPERAND_OPORT_SIZE 8
+#endif
+
+#ifndef DISPATCH_PORT_SIZE
+#define DISPATCH_PORT_SIZE 4
+#endif
+
+// the LSU holds its input while its pending reads are full, the
+// instructions queued behind it must not stall the operand stage.
+#ifndef FU_IPORT_SIZE
+#define FU_IPORT_SIZE 0
+#endif
+
 #define LSU_WORD_SIZE     (XLEN / 8)
 #define LSU_CHANNELS      NUM_LSU_LANES
 #define LSU_NUM_REQS	    (NUM_LSU_BLOCKS * LSU_CHANNELS)
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <assert.h>
 #include <util.h>
+#include <serialize.h>
 #include "types.h"
 #include "arch.h"
 #include "mem.h"
@@ -25,6 +26,13 @@
 
 using namespace vortex;
 
+// traces in flight: the fetched and buffered instructions
+// of each warp plus those queued past the issue stage.
+static uint32_t max_inflight_traces(const Arch& arch) {
+  return arch.num_warps() * (IBUF_SIZE + 2)
+       + ISSUE_WIDTH * (OPERAND_IPORT_SIZE + OPERAND_OPORT_SIZE + 2 * DISPATCH_PORT_SIZE + FU_IPORT_SIZE + LSUQ_IN_SIZE);
+}
+
 Core::Core(const SimContext& ctx,
            uint32_t core_id,
            Socket* socket,
@@ -38,7 +46,9 @@ Core::Core(const SimContext& ctx,
   , core_id_(core_id)
   , socket_(socket)
   , arch_(arch)
+  , trace_arena_(max_inflight_traces(arch))
   , emulator_(arch, dcrs, this)
+  , warp_sched_(WarpSchedType::Priority, arch.num_warps(), WARP_SCHED_GROUPS)
   , ibuffers_(arch.num_warps(), IBUF_SIZE)
   , scoreboard_(arch_)
   , operands_(ISSUE_WIDTH)
@@ -52,18 +62,18 @@ Core::Core(const SimContext& ctx,
   char sname[100];
 
   for (uint32_t i = 0; i < ISSUE_WIDTH; ++i) {
-    operands_.at(i) = SimPlatform::instance().create_object<Operand>();
+    operands_.at(i) = Operand::Create(ctx);
   }
 
   // create the memory coalescer
   for (uint32_t i = 0; i < NUM_LSU_BLOCKS; ++i) {
     snprintf(sname, 100, "core%d-coalescer%d", core_id, i);
-    mem_coalescers_.at(i) = MemCoalescer::Create(sname, LSU_CHANNELS, DCACHE_CHANNELS, DCACHE_WORD_SIZE, LSUQ_OUT_SIZE, 1);
+    mem_coalescers_.at(i) = MemCoalescer::Create(ctx, sname, LSU_CHANNELS, DCACHE_CHANNELS, DCACHE_WORD_SIZE, LSUQ_OUT_SIZE, 1);
   }
 
   // create local memory
   snprintf(sname, 100, "core%d-local_mem", core_id);
-  local_mem_ = LocalMem::Create(sname, LocalMem::Config{
+  local_mem_ = LocalMem::Create(ctx, sname, LocalMem::Config{
     (1 << LMEM_LOG_SIZE),
     LSU_WORD_SIZE,
     LSU_NUM_REQS,
@@ -74,7 +84,7 @@ Core::Core(const SimContext& ctx,
   // create lsu demux
   for (uint32_t i = 0; i < LSU_NUM_REQS; ++i) {
     snprintf(sname, 100, "core%d-lsu_demux%d", core_id, i);
-    lsu_demux_.at(i) = LocalMemDemux::Create(sname, 1);
+    lsu_demux_.at(i) = LocalMemDemux::Create(ctx, sname, 1);
   }
 
   // connect dcache-coalescer
@@ -101,27 +111,42 @@ Core::Core(const SimContext& ctx,
   }
 
   // initialize dispatchers
-  dispatchers_.at((int)FUType::ALU) = SimPlatform::instance().create_object<Dispatcher>(arch, 2, NUM_ALU_BLOCKS, NUM_ALU_LANES);
-  dispatchers_.at((int)FUType::FPU) = SimPlatform::instance().create_object<Dispatcher>(arch, 2, NUM_FPU_BLOCKS, NUM_FPU_LANES);
-  dispatchers_.at((int)FUType::LSU) = SimPlatform::instance().create_object<Dispatcher>(arch, 2, NUM_LSU_BLOCKS, NUM_LSU_LANES);
-  dispatchers_.at((int)FUType::SFU) = SimPlatform::instance().create_object<Dispatcher>(arch, 2, NUM_SFU_BLOCKS, NUM_SFU_LANES);
+  dispatchers_.at((int)FUType::ALU) = Dispatcher::Create(ctx, arch, &trace_arena_, 2, NUM_ALU_BLOCKS, NUM_ALU_LANES);
+  dispatchers_.at((int)FUType::FPU) = Dispatcher::Create(ctx, arch, &trace_arena_, 2, NUM_FPU_BLOCKS, NUM_FPU_LANES);
+  dispatchers_.at((int)FUType::LSU) = Dispatcher::Create(ctx, arch, &trace_arena_, 2, NUM_LSU_BLOCKS, NUM_LSU_LANES);
+  dispatchers_.at((int)FUType::SFU) = Dispatcher::Create(ctx, arch, &trace_arena_, 2, NUM_SFU_BLOCKS, NUM_SFU_LANES);
 
   // initialize execute units
-  func_units_.at((int)FUType::ALU) = SimPlatform::instance().create_object<AluUnit>(this);
-  func_units_.at((int)FUType::FPU) = SimPlatform::instance().create_object<FpuUnit>(this);
-  func_units_.at((int)FUType::LSU) = SimPlatform::instance().create_object<LsuUnit>(this);
-  func_units_.at((int)FUType::SFU) = SimPlatform::instance().create_object<SfuUnit>(this);
+  func_units_.at((int)FUType::ALU) = ctx.platform()->create_object<AluUnit>(this);
+  func_units_.at((int)FUType::FPU) = ctx.platform()->create_object<FpuUnit>(this);
+  func_units_.at((int)FUType::LSU) = ctx.platform()->create_object<LsuUnit>(this);
+  func_units_.at((int)FUType::SFU) = ctx.platform()->create_object<SfuUnit>(this);
 
   // bind commit arbiters
   for (uint32_t i = 0; i < ISSUE_WIDTH; ++i) {
     snprintf(sname, 100, "core%d-commit-arb%d", core_id, i);
-    auto arbiter = TraceSwitch::Create(sname, ArbiterType::RoundRobin, (uint32_t)FUType::Count, 1);
+    auto arbiter = TraceSwitch::Create(ctx, sname, ArbiterType::RoundRobin, (uint32_t)FUType::Count, 1);
     for (uint32_t j = 0; j < (uint32_t)FUType::Count; ++j) {
       func_units_.at(j)->Outputs.at(i).bind(&arbiter->Inputs.at(j));
     }
     commit_arbs_.at(i) = arbiter;
   }
 
+  // pipeline outputs are drained directly by the core
+  for (auto& operand : operands_) {
+    operand->Output.listener(this);
+  }
+  for (auto& dispatcher : dispatchers_) {
+    for (auto& output : dispatcher->Outputs) {
+      output.listener(this);
+    }
+  }
+  for (auto& commit_arb : commit_arbs_) {
+    for (auto& output : commit_arb->Outputs) {
+      output.listener(this);
+    }
+  }
+
   this->reset();
 }
 
@@ -133,6 +158,8 @@ void Core::reset() {
 
   emulator_.clear();
 
+  warp_sched_.reset();
+
   for (auto& commit_arb : commit_arbs_) {
     commit_arb->reset();
   }
@@ -150,6 +177,11 @@ void Core::reset() {
   pending_instrs_ = 0;
   pending_ifetches_ = 0;
 
+  sched_pending_ = false;
+  pending_resumes_.clear();
+
+  draining_ = false;
+
   perf_stats_ = PerfStats();
 }
 
@@ -159,19 +191,113 @@ void Core::tick() {
   this->issue();
   this->decode();
   this->fetch();
-  this->schedule();
+
+  // warp scheduling executes the instruction on the shared RAM,
+  // it runs in tock() to keep partitions in a deterministic order.
+  sched_pending_ = true;
+  this->request_tock();
+}
+
+void Core::tock() {
+  bool scheduled = !draining_ && this->schedule();
+  sched_pending_ = false;
+
+  // apply the resumes that followed the scheduling in tick order
+  bool resumed = !pending_resumes_.empty();
+  for (auto wid : pending_resumes_) {
+    emulator_.resume(wid);
+  }
+  pending_resumes_.clear();
 
   ++perf_stats_.cycles;
+
+  // nothing moves until a response arrives or a warp is resumed
+  if (!scheduled && !resumed && this->stalled()) {
+    this->idle();
+  }
+
   DPN(2, std::flush);
 }
 
-void Core::schedule() {
-  auto trace = emulator_.step();
-  if (trace == nullptr) {
+void Core::skip(uint64_t cycles) {
+  perf_stats_.cycles += cycles;
+  // a draining core does not schedule, see tock()
+  if (!draining_) {
+    warp_sched_.skip(cycles);
+    perf_stats_.sched_idle += cycles;
+    if (emulator_.running()) {
+      perf_stats_.sched_stalls += cycles;
+    }
+  }
+  perf_stats_.ifetch_latency += pending_ifetches_ * cycles;
+  if (!decode_latch_.empty()) {
+    perf_stats_.ibuf_stalls += cycles;
+  }
+
+  // the issue stage keeps cycling over the blocked ibuffers,
+  // visiting ISSUE_WIDTH consecutive (wrapping) indices per cycle.
+  uint64_t num_ibuffers = ibuffers_.size();
+  for (uint32_t ii = 0; ii < num_ibuffers; ++ii) {
+    auto& ibuffer = ibuffers_.at(ii);
+    if (ibuffer.empty())
+      continue;
+    uint64_t visits = 0;
+    uint64_t start = ibuffer_idx_;
+    uint64_t count = cycles * ISSUE_WIDTH;
+    while (count != 0) {
+      uint64_t len = std::min(count, (uint64_t(1) << 32) - start);
+      uint64_t offset = (ii + num_ibuffers - (start % num_ibuffers)) % num_ibuffers;
+      if (offset < len) {
+        visits += (len - offset - 1) / num_ibuffers + 1;
+      }
+      start = 0;
+      count -= len;
+    }
+    if (visits != 0) {
+      scoreboard_.get_uses(ibuffer.top(), reg_uses_);
+      this->count_stalls(reg_uses_, visits);
+    }
+  }
+  ibuffer_idx_ += uint32_t(cycles * ISSUE_WIDTH);
+}
+
+bool Core::stalled() {
+  if (!fetch_latch_.empty()
+   || !icache_rsp_ports.at(0).empty())
+    return false;
+  if (!decode_latch_.empty()
+   && !ibuffers_.at(decode_latch_.front()->wid).full())
+    return false;
+  for (auto& ibuffer : ibuffers_) {
+    if (!ibuffer.empty() && !scoreboard_.in_use(ibuffer.top()))
+      return false;
+  }
+  for (uint32_t i = 0; i < ISSUE_WIDTH; ++i) {
+    if (!operands_.at(i)->Output.empty()
+     || !commit_arbs_.at(i)->Outputs.at(0).empty())
+      return false;
+    for (auto& dispatcher : dispatchers_) {
+      if (!dispatcher->Outputs.at(i).empty())
+        return false;
+    }
+  }
+  return true;
+}
+
+bool Core::schedule() {
+  int wid = warp_sched_.select(emulator_.ready_warps());
+  perf_stats_.sched_misses = warp_sched_.perf_stats().misses;
+  perf_stats_.sched_switches = warp_sched_.perf_stats().switches;
+  if (wid == -1) {
     ++perf_stats_.sched_idle;
-    return;
+    if (emulator_.running()) {
+      ++perf_stats_.sched_stalls;
+    }
+    return false;
   }
 
+  auto trace = emulator_.step(wid);
+
   // suspend warp until decode
   emulator_.suspend(trace->wid);
 
@@ -180,6 +306,7 @@ void Core::schedule() {
   // advance to fetch stage
   fetch_latch_.push(trace);
   ++pending_instrs_;
+  return true;
 }
 
 void Core::fetch() {
@@ -273,7 +400,8 @@ void Core::issue() {
 
     // check scoreboard
     if (scoreboard_.in_use(trace)) {
-      auto uses = scoreboard_.get_uses(trace);
+      auto& uses = reg_uses_;
+      scoreboard_.get_uses(trace, uses);
       if (!trace->log_once(true)) {
         DTH(4, "*** scoreboard-stall: dependents={");
         for (uint32_t j = 0, n = uses.size(); j < n; ++j) {
@@ -284,36 +412,17 @@ void Core::issue() {
         }
         DTN(4, "}, " << *trace << std::endl);
       }
-      for (uint32_t j = 0, n = uses.size(); j < n; ++j) {
-        auto& use = uses.at(j);
-        switch (use.fu_type) {
-        case FUType::ALU: ++perf_stats_.scrb_alu; break;
-        case FUType::FPU: ++perf_stats_.scrb_fpu; break;
-        case FUType::LSU: ++perf_stats_.scrb_lsu; break;
-        case FUType::SFU: {
-          ++perf_stats_.scrb_sfu;
-          switch (use.sfu_type) {
-          case SfuType::TMC:
-          case SfuType::WSPAWN:
-          case SfuType::SPLIT:
-          case SfuType::JOIN:
-          case SfuType::BAR:
-          case SfuType::PRED: ++perf_stats_.scrb_wctl; break;
-          case SfuType::CSRRW:
-          case SfuType::CSRRS:
-          case SfuType::CSRRC: ++perf_stats_.scrb_csrs; break;
-          default: assert(false);
-          }
-        } break;
-        default: assert(false);
-        }
-      }
-      ++perf_stats_.scrb_stalls;
+      this->count_stalls(uses, 1);
       continue;
     } else {
       trace->log_once(false);
     }
 
+    // check operand port capacity
+    auto& operand = operands_.at(i);
+    if (operand->Input.full())
+      continue;
+
     // update scoreboard
     if (trace->wb) {
       scoreboard_.reserve(trace);
@@ -322,19 +431,51 @@ void Core::issue() {
     DT(3, "pipeline-scoreboard: " << *trace);
 
     // to operand stage
-    operands_.at(i)->Input.push(trace, 1);
+    operand->Input.push(trace, 1);
 
     ibuffer.pop();
   }
   ibuffer_idx_ += ISSUE_WIDTH;
 }
 
+void Core::count_stalls(const std::vector<Scoreboard::reg_use_t>& uses, uint64_t count) {
+  for (uint32_t j = 0, n = uses.size(); j < n; ++j) {
+    auto& use = uses.at(j);
+    switch (use.fu_type) {
+    case FUType::ALU: perf_stats_.scrb_alu += count; break;
+    case FUType::FPU: perf_stats_.scrb_fpu += count; break;
+    case FUType::LSU: perf_stats_.scrb_lsu += count; break;
+    case FUType::SFU: {
+      perf_stats_.scrb_sfu += count;
+      switch (use.sfu_type) {
+      case SfuType::TMC:
+      case SfuType::WSPAWN:
+      case SfuType::SPLIT:
+      case SfuType::JOIN:
+      case SfuType::BAR:
+      case SfuType::PRED: perf_stats_.scrb_wctl += count; break;
+      case SfuType::CSRRW:
+      case SfuType::CSRRS:
+      case SfuType::CSRRC: perf_stats_.scrb_csrs += count; break;
+      case SfuType::SHFL:
+      case SfuType::VOTE:
+      case SfuType::REDUCE: break;
+      default: assert(false);
+      }
+    } break;
+    default: assert(false);
+    }
+  }
+  perf_stats_.scrb_stalls += count;
+}
+
 void Core::execute() {
   for (uint32_t i = 0; i < (uint32_t)FUType::Count; ++i) {
     auto& dispatch = dispatchers_.at(i);
     auto& func_unit = func_units_.at(i);
     for (uint32_t j = 0; j < ISSUE_WIDTH; ++j) {
-      if (dispatch->Outputs.at(j).empty())
+      if (dispatch->Outputs.at(j).empty()
+       || func_unit->Inputs.at(j).full())
         continue;
       auto trace = dispatch->Outputs.at(j).front();
       func_unit->Inputs.at(j).push(trace, 1);
@@ -368,8 +509,8 @@ void Core::commit() {
 
     commit_arb->Outputs.at(0).pop();
 
-    // delete the trace
-    delete trace;
+    // release the trace
+    trace_arena_.release(trace);
   }
 }
 
@@ -381,15 +522,65 @@ bool Core::running() const {
   return emulator_.running() || (pending_instrs_ != 0);
 }
 
+uint32_t Core::step_functional() {
+  ++perf_stats_.cycles;
+  auto num_threads = emulator_.step_functional();
+  if (0 == num_threads) {
+    ++perf_stats_.sched_idle;
+    return 0;
+  }
+  perf_stats_.instrs += num_threads;
+  return num_threads;
+}
+
+void Core::set_region(Word start_pc, uint32_t window_size) {
+  emulator_.set_region(start_pc, window_size);
+}
+
+std::vector<Emulator::mem_access_t> Core::access_window() const {
+  return emulator_.access_window();
+}
+
+void Core::set_warp_scheduler(WarpSchedType type) {
+  warp_sched_ = WarpScheduler(type, arch_.num_warps(), WARP_SCHED_GROUPS);
+}
+
+void Core::drain() {
+  draining_ = true;
+  this->wakeup();
+}
+
+void Core::save(std::ostream& os) const {
+  assert(0 == pending_instrs_);
+  serialize(os, perf_stats_);
+  emulator_.save(os);
+  warp_sched_.save(os);
+  local_mem_->save(os);
+}
+
+void Core::load(std::istream& is) {
+  deserialize(is, perf_stats_);
+  emulator_.load(is);
+  warp_sched_.load(is);
+  local_mem_->load(is);
+}
+
 void Core::resume(uint32_t wid) {
-  emulator_.resume(wid);
+  if (sched_pending_) {
+    pending_resumes_.push_back(wid);
+  } else {
+    emulator_.resume(wid);
+  }
+  this->wakeup();
 }
 
 bool Core::barrier(uint32_t bar_id, uint32_t count, uint32_t wid) {
+  this->wakeup();
   return emulator_.barrier(bar_id, count, wid);
 }
 
 bool Core::wspawn(uint32_t num_warps, Word nextPC) {
+  this->wakeup();
   return emulator_.wspawn(num_warps, nextPC);
 }
 
@@ -26,6 +26,7 @@
 #include "dispatcher.h"
 #include "func_unit.h"
 #include "mem_coalescer.h"
+#include "warp_sched.h"
 
 namespace vortex {
 
@@ -42,6 +43,8 @@ public:
     uint64_t instrs;
     uint64_t sched_idle;
     uint64_t sched_stalls;
+    uint64_t sched_misses;
+    uint64_t sched_switches;
     uint64_t ibuf_stalls;
     uint64_t scrb_stalls;
     uint64_t scrb_alu;
@@ -61,6 +64,8 @@ public:
       , instrs(0)
       , sched_idle(0)
       , sched_stalls(0)
+      , sched_misses(0)
+      , sched_switches(0)
       , ibuf_stalls(0)
       , scrb_stalls(0)
       , scrb_alu(0)
@@ -95,10 +100,37 @@ public:
 
   void tick();
 
+  void tock();
+
+  void skip(uint64_t cycles);
+
   void attach_ram(RAM* ram);
 
   bool running() const;
 
+  // functional mode: execute one instruction, bypassing the pipeline,
+  // returns the number of threads that executed it.
+  uint32_t step_functional();
+
+  // hybrid mode, see Emulator::set_region()
+  void set_region(Word start_pc, uint32_t window_size);
+
+  std::vector<Emulator::mem_access_t> access_window() const;
+
+  void set_warp_scheduler(WarpSchedType type);
+
+  // stop scheduling new instructions and let the pipeline empty
+  void drain();
+
+  bool drained() const {
+    return (0 == pending_instrs_);
+  }
+
+  // checkpoint the architectural state, the pipeline should be empty
+  void save(std::ostream& os) const;
+
+  void load(std::istream& is);
+
   void resume(uint32_t wid);
 
   bool barrier(uint32_t bar_id, uint32_t count, uint32_t wid);
@@ -121,6 +153,10 @@ public:
     return local_mem_;
   }
 
+  TraceArena& trace_arena() {
+    return trace_arena_;
+  }
+
   const PerfStats& perf_stats() const {
     return perf_stats_;
   }
@@ -129,21 +165,30 @@ public:
 
 private:
 
-  void schedule();
+  bool schedule();
   void fetch();
   void decode();
   void issue();
   void execute();
   void commit();
 
+  bool stalled();
+
+  void count_stalls(const std::vector<Scoreboard::reg_use_t>& uses, uint64_t count);
+
   uint32_t core_id_;
   Socket* socket_;
   const Arch& arch_;
 
+  TraceArena trace_arena_;
+
   Emulator emulator_;
 
+  WarpScheduler warp_sched_;
+
   std::vector<IBuffer> ibuffers_;
   Scoreboard scoreboard_;
+  std::vector<Scoreboard::reg_use_t> reg_uses_;
   std::vector<Operand::Ptr> operands_;
   std::vector<Dispatcher::Ptr> dispatchers_;
   std::vector<FuncUnit::Ptr> func_units_;
@@ -166,6 +211,11 @@ private:
   uint32_t commit_exe_;
   uint32_t ibuffer_idx_;
 
+  bool sched_pending_;
+  std::vector<uint32_t> pending_resumes_;
+
+  bool draining_;
+
   friend class LsuUnit;
   friend class AluUnit;
   friend class FpuUnit;
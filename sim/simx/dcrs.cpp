@@ -25,4 +25,12 @@ void DCRS::write(uint32_t addr, uint32_t value) {
 
   std::cout << std::hex << "Error: invalid global DCR addr=0x" << addr << std::endl;
   std::abort();
-}
\ No newline at end of file
+}
+
+void DCRS::save(std::ostream& os) const {
+  base_dcrs.save(os);
+}
+
+void DCRS::load(std::istream& is) {
+  base_dcrs.load(is);
+}
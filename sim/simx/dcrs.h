@@ -14,6 +14,7 @@
 #pragma once
 
 #include <util.h>
+#include <serialize.h>
 #include <VX_types.h>
 #include <array>
 
@@ -31,6 +32,14 @@ public:
 		states_.at(state) = value;
 	}
 
+  void save(std::ostream& os) const {
+    serialize(os, states_);
+  }
+
+  void load(std::istream& is) {
+    deserialize(is, states_);
+  }
+
 private:
   std::array<uint32_t, VX_DCR_BASE_STATE_COUNT> states_;
 };
@@ -39,6 +48,10 @@ class DCRS {
 public:
   void write(uint32_t addr, uint32_t value);
 
+  void save(std::ostream& os) const;
+
+  void load(std::istream& is);
+
   BaseDCRS base_dcrs;
 };
 
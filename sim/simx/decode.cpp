@@ -49,6 +49,7 @@ static const std::unordered_map<Opcode, InstType> sc_instTable = {
   {Opcode::FMNMSUB, InstType::R4},
   {Opcode::EXT1,    InstType::R},
   {Opcode::EXT2,    InstType::R4},
+  {Opcode::EXT3,    InstType::R},
   {Opcode::R_W,     InstType::R},
   {Opcode::I_W,     InstType::I},
 };
@@ -103,7 +104,7 @@ static const char* op_string(const Instr &instr) {
         std::abort();
       }
     } else
-    if (func7 & 0x1) {
+    if (func7 == 0x1) {
       switch (func3) {
       case 0: return "MUL";
       case 1: return "MULH";
@@ -116,16 +117,44 @@ static const char* op_string(const Instr &instr) {
       default:
         std::abort();
       }
+    } else
+    if (func7 != 0x0 && func7 != 0x20) {
+      switch (func7) {
+      case 0x04: return "ZEXT.H";
+      case 0x05:
+        switch (func3) {
+        case 4: return "MIN";
+        case 5: return "MINU";
+        case 6: return "MAX";
+        case 7: return "MAXU";
+        default:
+          std::abort();
+        }
+      case 0x10:
+        switch (func3) {
+        case 2: return "SH1ADD";
+        case 4: return "SH2ADD";
+        case 6: return "SH3ADD";
+        default:
+          std::abort();
+        }
+      case 0x14: return "BSET";
+      case 0x24: return (func3 == 1) ? "BCLR" : "BEXT";
+      case 0x30: return (func3 == 1) ? "ROL" : "ROR";
+      case 0x34: return "BINV";
+      default:
+        std::abort();
+      }
     } else {
       switch (func3) {
       case 0: return (func7 & 0x20) ? "SUB" : "ADD";
       case 1: return "SLL";
       case 2: return "SLT";
       case 3: return "SLTU";
-      case 4: return "XOR";
+      case 4: return (func7 & 0x20) ? "XNOR" : "XOR";
       case 5: return (func7 & 0x20) ? "SRA" : "SRL";
-      case 6: return "OR";
-      case 7: return "AND";
+      case 6: return (func7 & 0x20) ? "ORN" : "OR";
+      case 7: return (func7 & 0x20) ? "ANDN" : "AND";
       default:
         std::abort();
       }
@@ -133,11 +162,39 @@ static const char* op_string(const Instr &instr) {
   case Opcode::I:
     switch (func3) {
     case 0: return "ADDI";
-    case 1: return "SLLI";
+    case 1:
+      switch (func7 & ~0x1) {
+      case 0x00: return "SLLI";
+      case 0x14: return "BSETI";
+      case 0x24: return "BCLRI";
+      case 0x34: return "BINVI";
+      case 0x30:
+        switch (imm) {
+        case 0: return "CLZ";
+        case 1: return "CTZ";
+        case 2: return "CPOP";
+        case 4: return "SEXT.B";
+        case 5: return "SEXT.H";
+        default:
+          std::abort();
+        }
+      default:
+        std::abort();
+      }
     case 2: return "SLTI";
     case 3: return "SLTIU";
     case 4: return "XORI";
-    case 5: return (func7 & 0x20) ? "SRAI" : "SRLI";
+    case 5:
+      switch (func7 & ~0x1) {
+      case 0x00: return "SRLI";
+      case 0x20: return "SRAI";
+      case 0x14: return "ORC.B";
+      case 0x24: return "BEXTI";
+      case 0x30: return "RORI";
+      case 0x34: return "REV8";
+      default:
+        std::abort();
+      }
     case 6: return "ORI";
     case 7: return "ANDI";
     default:
@@ -188,6 +245,22 @@ static const char* op_string(const Instr &instr) {
       default:
         std::abort();
       }
+    } else
+    if (func7 != 0x0 && func7 != 0x20) {
+      switch (func7) {
+      case 0x04: return (func3 == 0) ? "ADD.UW" : "ZEXT.H";
+      case 0x10:
+        switch (func3) {
+        case 2: return "SH1ADD.UW";
+        case 4: return "SH2ADD.UW";
+        case 6: return "SH3ADD.UW";
+        default:
+          std::abort();
+        }
+      case 0x30: return (func3 == 1) ? "ROLW" : "RORW";
+      default:
+        std::abort();
+      }
     } else {
       switch (func3) {
       case 0: return (func7 & 0x20) ? "SUBW" : "ADDW";
@@ -200,8 +273,23 @@ static const char* op_string(const Instr &instr) {
   case Opcode::I_W:
     switch (func3) {
     case 0: return "ADDIW";
-    case 1: return "SLLIW";
-    case 5: return (func7 & 0x20) ? "SRAIW" : "SRLIW";
+    case 1:
+      if ((func7 & ~0x1) == 0x04)
+        return "SLLI.UW";
+      if (func7 == 0x30) {
+        switch (imm) {
+        case 0: return "CLZW";
+        case 1: return "CTZW";
+        case 2: return "CPOPW";
+        default:
+          std::abort();
+        }
+      }
+      return "SLLIW";
+    case 5:
+      if (func7 == 0x30)
+        return "RORIW";
+      return (func7 & 0x20) ? "SRAIW" : "SRLIW";
     default:
       std::abort();
     }
@@ -405,6 +493,34 @@ static const char* op_string(const Instr &instr) {
     default:
       std::abort();
     }
+  case Opcode::EXT3:
+    switch (func3) {
+    case 0:
+      switch (func7) {
+      case 0: return "SHFL.IDX";
+      case 1: return "SHFL.UP";
+      case 2: return "SHFL.DOWN";
+      case 3: return "SHFL.XOR";
+      default:
+        std::abort();
+      }
+    case 1:
+      switch (func7) {
+      case 0: return "VOTE.ANY";
+      case 1: return "VOTE.ALL";
+      case 2: return "VOTE.BALLOT";
+      default:
+        std::abort();
+      }
+    case 2:
+      switch (func7) {
+      case 0: return "REDUCE.ADD";
+      default:
+        std::abort();
+      }
+    default:
+      std::abort();
+    }
   default:
     std::abort();
   }
@@ -531,7 +647,31 @@ std::shared_ptr<Instr> Emulator::decode(uint32_t code) const {
         std::abort();
       }
       break;
+    case Opcode::EXT3:
+      switch (func3) {
+      case 0: // SHFL
+        instr->setDestReg(rd, RegType::Integer);
+        instr->addSrcReg(rs1, RegType::Integer);
+        instr->addSrcReg(rs2, RegType::Integer);
+        break;
+      case 1: // VOTE
+      case 2: // REDUCE
+        instr->setDestReg(rd, RegType::Integer);
+        instr->addSrcReg(rs1, RegType::Integer);
+        break;
+      default:
+        std::abort();
+      }
+      break;
     default:
+      if ((op == Opcode::R || op == Opcode::R_W) && func7 == 0x04) {
+        // ZEXT.H is PACK(W) with rs2=x0, the OP form is RV32 only.
+        // the other PACK(W) encodings are not supported.
+        bool zext_h = (func3 == 4 && rs2 == 0 && (op == Opcode::R_W || XLEN == 32));
+        bool add_uw = (func3 == 0 && op == Opcode::R_W);
+        if (!zext_h && !add_uw)
+          return nullptr;
+      }
       instr->setDestReg(rd, RegType::Integer);
       instr->addSrcReg(rs1, RegType::Integer);
       instr->addSrcReg(rs2, RegType::Integer);
@@ -553,8 +693,8 @@ std::shared_ptr<Instr> Emulator::decode(uint32_t code) const {
         // Shift instructions
         auto shamt = rs2; // uint5
       #if (XLEN == 64)
-        if (op == Opcode::I) {
-          // uint6
+        if (op == Opcode::I || (func7 & ~0x1) == 0x04) {
+          // uint6, including SLLI.UW
           shamt |= ((func7 & 0x1) << 5);
         }
       #endif
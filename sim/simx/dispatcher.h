@@ -14,7 +14,7 @@
 #pragma once
 
 #include "instr_trace.h"
-#include <queue>
+#include "constants.h"
 #include <vector>
 
 namespace vortex {
@@ -23,12 +23,13 @@ class Dispatcher : public SimObject<Dispatcher> {
 public:
 	std::vector<SimPort<instr_trace_t*>> Outputs;
 
-	Dispatcher(const SimContext& ctx, const Arch& arch, uint32_t buf_size, uint32_t block_size, uint32_t num_lanes) 
+	Dispatcher(const SimContext& ctx, const Arch& arch, TraceArena* trace_arena, uint32_t buf_size, uint32_t block_size, uint32_t num_lanes) 
 		: SimObject<Dispatcher>(ctx, "Dispatcher") 
-		, Outputs(ISSUE_WIDTH, this)
-		, Inputs_(ISSUE_WIDTH, this)
+		, Outputs(ISSUE_WIDTH, SimPort<instr_trace_t*>(this, DISPATCH_PORT_SIZE))
+		, Inputs_(ISSUE_WIDTH, SimPort<instr_trace_t*>(this, DISPATCH_PORT_SIZE))
 		, arch_(arch)
-		, queues_(ISSUE_WIDTH, std::queue<instr_trace_t*>())
+		, trace_arena_(trace_arena)
+		, queues_(ISSUE_WIDTH, RingQueue<instr_trace_t*>(buf_size))
 		, buf_size_(buf_size)
 		, block_size_(block_size)
 		, num_lanes_(num_lanes)
@@ -50,7 +51,7 @@ public:
 	virtual void tick() {
 		for (uint32_t i = 0; i < ISSUE_WIDTH; ++i) {
 			auto& queue = queues_.at(i);
-			if (queue.empty())
+			if (queue.empty() || Inputs_.at(i).full())
 				continue;
 			auto trace = queue.front();
 			Inputs_.at(i).push(trace, 1);
@@ -66,6 +67,8 @@ public:
 				continue;
 			}
 			auto& output = Outputs.at(i);
+			if (output.full())
+				continue;
 			auto trace = input.front();
 			auto new_trace = trace;
 			if (pid_count_ != 1) {
@@ -85,7 +88,7 @@ public:
 				start /= num_lanes_;
 				end /= num_lanes_;
 				if (start != end) {
-					new_trace = new instr_trace_t(*trace);
+					new_trace = trace_arena_->clone(*trace);
 					new_trace->eop = false;
 					start_p_.at(b) = start + 1;
 				} else {
@@ -114,20 +117,38 @@ public:
 				start_p_.at(b) = 0;
 			}
 		}
+
+		// sleep until new instructions are pushed,
+		// idle batch rotation is only a no-op with a single batch.
+		for (uint32_t i = 0; i < ISSUE_WIDTH; ++i) {
+			if (!queues_.at(i).empty() || !Inputs_.at(i).empty())
+				return;
+		}
+		if (batch_count_ == 1) {
+			this->sleep();
+		} else {
+			this->idle();
+		}
 	};
 
+	void skip(uint64_t cycles) {
+		batch_idx_ = (batch_idx_ + cycles) % batch_count_;
+	}
+
 	bool push(uint32_t issue_index, instr_trace_t* trace) {
 		auto& queue = queues_.at(issue_index);
 		if (queue.size() >= buf_size_)
 			return false;
 		queue.push(trace);
+		this->wakeup();
 		return true;
 	}
 
 private:
 	std::vector<SimPort<instr_trace_t*>> Inputs_;
 	const Arch& arch_;
-	std::vector<std::queue<instr_trace_t*>> queues_;
+	TraceArena* trace_arena_;
+	std::vector<RingQueue<instr_trace_t*>> queues_;
 	uint32_t buf_size_;
 	uint32_t block_size_;
 	uint32_t num_lanes_;
@@ -17,6 +17,7 @@
 #include <math.h>
 #include <assert.h>
 #include <util.h>
+#include <serialize.h>
 
 #include "emulator.h"
 #include "instr_trace.h"
@@ -27,6 +28,7 @@
 #include "cluster.h"
 #include "processor_impl.h"
 #include "local_mem.h"
+#include "constants.h"
 
 using namespace vortex;
 
@@ -42,8 +44,8 @@ Emulator::ipdom_entry_t::ipdom_entry_t(const ThreadMask &tmask)
 {}
 
 Emulator::warp_t::warp_t(const Arch& arch)
-  : ireg_file(arch.num_threads(), std::vector<Word>(arch.num_regs()))
-  , freg_file(arch.num_threads(), std::vector<uint64_t>(arch.num_regs()))
+  : ireg_file(arch.num_regs(), arch.num_threads())
+  , freg_file(arch.num_regs(), arch.num_threads())
 {}
 
 void Emulator::warp_t::clear(uint64_t startup_addr) {
@@ -52,17 +54,8 @@ void Emulator::warp_t::clear(uint64_t startup_addr) {
   this->uui_gen.reset();
   this->fcsr = 0;
 
-  for (auto& reg_file : this->ireg_file) {
-    for (auto& reg : reg_file) {
-      reg = 0;
-    }
-  }
-
-  for (auto& reg_file : this->freg_file) {
-    for (auto& reg : reg_file) {
-      reg = 0;
-    }
-  }
+  this->ireg_file.clear();
+  this->freg_file.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -73,7 +66,12 @@ Emulator::Emulator(const Arch &arch, const DCRS &dcrs, Core* core)
     , core_(core)
     , warps_(arch.num_warps(), arch)
     , barriers_(arch.num_barriers(), 0)
+    , region_pc_(0)
+  , decode_cache_(DECODE_CACHE_SIZE)
+  , processor_(core->socket()->cluster()->processor())
+  , code_epoch_(0)
 {
+  this->init_csrs();
   this->clear();
 }
 
@@ -109,6 +107,15 @@ void Emulator::clear() {
   active_warps_.set(0);
   warps_[0].tmask.set(0);
   wspawn_.valid = false;
+  functional_wid_ = 0;
+
+  // the host may have loaded new code
+  this->flush_decode_cache();
+  code_epoch_ = processor_->code_epoch();
+
+  access_head_ = 0;
+  access_size_ = 0;
+  last_fetch_line_ = uint64_t(-1);
 }
 
 void Emulator::attach_ram(RAM* ram) {
@@ -120,9 +127,174 @@ void Emulator::attach_ram(RAM* ram) {
 #endif
 }
 
-instr_trace_t* Emulator::step() {
-  int scheduled_warp = -1;
+instr_trace_t* Emulator::step(uint32_t wid) {
+  // Create trace
+  auto trace = core_->trace_arena().allocate(this->get_uuid(wid), arch_);
+
+  this->fetch_execute(wid, trace);
+
+  return trace;
+}
+
+uint32_t Emulator::step_functional() {
+  // warps take turns, nothing else keeps the current one from running again
+  int scheduled_warp = this->schedule_warp(functional_wid_);
+  if (scheduled_warp == -1)
+    return 0;
+  functional_wid_ = (scheduled_warp + 1) % arch_.num_warps();
+
+  instr_trace_t trace(this->get_uuid(scheduled_warp), arch_);
+
+  this->fetch_execute(scheduled_warp, &trace);
+
+  if (trace.PC == region_pc_) {
+    core_->socket()->cluster()->processor()->region_trigger();
+  }
+
+  if (!access_window_.empty()) {
+    this->record_accesses(trace);
+  }
+
+  // apply warp spawns and barriers right away,
+  // the warp stays suspended until they release it.
+  if (trace.fetch_stall && trace.fu_type == FUType::SFU) {
+    switch (trace.sfu_type) {
+    case SfuType::WSPAWN: {
+      auto trace_data = std::dynamic_pointer_cast<SFUTraceData>(trace.data);
+      this->suspend(scheduled_warp);
+      if (this->wspawn(trace_data->arg1, trace_data->arg2)) {
+        this->resume(scheduled_warp);
+      }
+    } break;
+    case SfuType::BAR: {
+      auto trace_data = std::dynamic_pointer_cast<SFUTraceData>(trace.data);
+      this->suspend(scheduled_warp);
+      if (this->barrier(trace_data->arg1, trace_data->arg2, scheduled_warp)) {
+        this->resume(scheduled_warp);
+      }
+    } break;
+    default:
+      break;
+    }
+  }
+
+  return trace.tmask.count();
+}
+
+void Emulator::save(std::ostream& os) const {
+  for (auto& warp : warps_) {
+    serialize(os, warp.PC);
+    serialize(os, warp.tmask);
+    serialize(os, warp.ireg_file.data());
+    serialize(os, warp.freg_file.data());
+    serialize(os, warp.fcsr);
+    // ipdom stack, bottom entry first
+    auto ipdom_stack = warp.ipdom_stack;
+    std::vector<ipdom_entry_t> ipdom_entries;
+    while (!ipdom_stack.empty()) {
+      ipdom_entries.push_back(ipdom_stack.top());
+      ipdom_stack.pop();
+    }
+    serialize(os, uint64_t(ipdom_entries.size()));
+    for (auto it = ipdom_entries.rbegin(); it != ipdom_entries.rend(); ++it) {
+      serialize(os, it->tmask);
+      serialize(os, it->PC);
+      serialize(os, it->fallthrough);
+    }
+  }
+  serialize(os, active_warps_);
+  serialize(os, stalled_warps_);
+  serialize(os, barriers_);
+  serialize(os, csr_mscratch_);
+  serialize(os, wspawn_.valid);
+  serialize(os, wspawn_.num_warps);
+  serialize(os, wspawn_.nextPC);
+  serialize(os, functional_wid_);
+}
+
+void Emulator::load(std::istream& is) {
+  for (auto& warp : warps_) {
+    deserialize(is, warp.PC);
+    deserialize(is, warp.tmask);
+    deserialize(is, warp.ireg_file.data());
+    deserialize(is, warp.freg_file.data());
+    deserialize(is, warp.fcsr);
+    warp.ipdom_stack = std::stack<ipdom_entry_t>();
+    uint64_t ipdom_size = 0;
+    deserialize(is, ipdom_size);
+    for (uint64_t i = 0; i < ipdom_size && is; ++i) {
+      ipdom_entry_t entry(0);
+      deserialize(is, entry.tmask);
+      deserialize(is, entry.PC);
+      deserialize(is, entry.fallthrough);
+      warp.ipdom_stack.push(entry);
+    }
+  }
+  deserialize(is, active_warps_);
+  deserialize(is, stalled_warps_);
+  deserialize(is, barriers_);
+  deserialize(is, csr_mscratch_);
+  deserialize(is, wspawn_.valid);
+  deserialize(is, wspawn_.num_warps);
+  deserialize(is, wspawn_.nextPC);
+  deserialize(is, functional_wid_);
+}
+
+void Emulator::set_region(Word start_pc, uint32_t window_size) {
+  region_pc_ = start_pc;
+  access_window_.resize(window_size);
+  access_head_ = 0;
+  access_size_ = 0;
+}
+
+std::vector<Emulator::mem_access_t> Emulator::access_window() const {
+  std::vector<mem_access_t> accesses;
+  uint32_t window_size = access_window_.size();
+  for (uint32_t i = 0; i < access_size_; ++i) {
+    accesses.push_back(access_window_.at((access_head_ + window_size - access_size_ + i) % window_size));
+  }
+  return accesses;
+}
+
+void Emulator::record_accesses(const instr_trace_t& trace) {
+  uint32_t window_size = access_window_.size();
+  auto record = [&](uint64_t addr, bool write, bool ifetch) {
+    access_window_.at(access_head_) = mem_access_t{addr, write, ifetch};
+    access_head_ = (access_head_ + 1) % window_size;
+    access_size_ = std::min(access_size_ + 1, window_size);
+  };
+
+  // sequential fetches from the same line hit in the icache
+  uint64_t fetch_line = trace.PC / L1_LINE_SIZE;
+  if (fetch_line != last_fetch_line_) {
+    record(trace.PC, false, true);
+    last_fetch_line_ = fetch_line;
+  }
+
+  if (trace.fu_type != FUType::LSU
+   || trace.lsu_type == LsuType::FENCE)
+    return;
+
+  // threads of the same instruction are coalesced by line,
+  // shared memory and IO accesses never reach the caches.
+  auto trace_data = std::dynamic_pointer_cast<LsuTraceData>(trace.data);
+  bool write = (trace.lsu_type == LsuType::STORE);
+  uint64_t last_line = uint64_t(-1);
+  for (uint32_t t = 0, n = arch_.num_threads(); t < n; ++t) {
+    if (!trace.tmask.test(t))
+      continue;
+    uint64_t addr = trace_data->mem_addrs.at(t).addr;
+    if (get_addr_type(addr) != AddrType::Global)
+      continue;
+    uint64_t line = addr / L1_LINE_SIZE;
+    if (line == last_line)
+      continue;
+    record(addr, write, false);
+    last_line = line;
+  }
+}
 
+uint64_t Emulator::ready_warps() {
   // process pending wspawn
   if (wspawn_.valid && active_warps_.count() == 1) {
     DP(3, "*** Activate " << (wspawn_.num_warps-1) << " warps at PC: " << std::hex << wspawn_.nextPC);
@@ -135,71 +307,154 @@ instr_trace_t* Emulator::step() {
     wspawn_.valid = false;
     stalled_warps_.reset(0);
   }
+  return (active_warps_ & ~stalled_warps_).to_ullong();
+}
+
+int Emulator::schedule_warp(uint32_t start_wid) {
+  auto ready = this->ready_warps();
 
   // find next ready warp
-  for (size_t wid = 0, nw = arch_.num_warps(); wid < nw; ++wid) {
-    bool warp_active = active_warps_.test(wid);
-    bool warp_stalled = stalled_warps_.test(wid);
-    if (warp_active && !warp_stalled) {
-      scheduled_warp = wid;
-      break;
-    }
+  for (size_t i = 0, nw = arch_.num_warps(); i < nw; ++i) {
+    size_t wid = (start_wid + i) % nw;
+    if ((ready >> wid) & 0x1)
+      return wid;
   }
-  if (scheduled_warp == -1)
-    return nullptr;
 
-  // suspend warp until decode
-  auto& warp = warps_.at(scheduled_warp);
-  assert(warp.tmask.any());
+  return -1;
+}
 
+uint64_t Emulator::get_uuid(uint32_t wid) {
 #ifndef NDEBUG
+  auto& warp = warps_.at(wid);
   uint32_t instr_uuid = warp.uui_gen.get_uuid(warp.PC);
-  uint32_t g_wid = core_->id() * arch_.num_warps() + scheduled_warp;
-  uint64_t uuid = (uint64_t(g_wid) << 32) | instr_uuid;
+  uint32_t g_wid = core_->id() * arch_.num_warps() + wid;
+  return (uint64_t(g_wid) << 32) | instr_uuid;
 #else
-  uint64_t uuid = 0;
+  __unused (wid);
+  return 0;
 #endif
+}
+
+void Emulator::fetch_execute(uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  assert(warp.tmask.any());
 
-  DPH(1, "Fetch: cid=" << core_->id() << ", wid=" << scheduled_warp << ", tmask=");
+  DPH(1, "Fetch: cid=" << core_->id() << ", wid=" << wid << ", tmask=");
   for (uint32_t i = 0, n = arch_.num_threads(); i < n; ++i)
     DPN(1, warp.tmask.test(i));
-  DPN(1, ", PC=0x" << std::hex << warp.PC << " (#" << std::dec << uuid << ")" << std::endl);
+  DPN(1, ", PC=0x" << std::hex << warp.PC << " (#" << std::dec << trace->uuid << ")" << std::endl);
 
-  // Fetch
-  uint32_t instr_code = 0;
-  this->icache_read(&instr_code, warp.PC, sizeof(uint32_t));
+  // Fetch + Decode
+  auto& entry = this->fetch_decode(warp.PC, trace->uuid);
 
-  // Decode
-  auto instr = this->decode(instr_code);
-  if (!instr) {
-    std::cout << std::hex << "Error: invalid instruction 0x" << instr_code << ", at PC=0x" << warp.PC << " (#" << std::dec << uuid << ")" << std::endl;
-    std::abort();
-  }
-
-  DP(1, "Instr 0x" << std::hex << instr_code << ": " << *instr);
-
-  // Create trace
-  auto trace = new instr_trace_t(uuid, arch_);
+  DP(1, "Instr 0x" << std::hex << entry.code << ": " << *entry.instr);
 
   // Execute
-  this->execute(*instr, scheduled_warp, trace);
+  if (entry.handler) {
+#ifndef NDEBUG
+    this->check_handler(entry, wid, trace);
+#else
+    (this->*entry.handler)(entry, wid, trace);
+#endif
+  } else {
+    auto instr = entry.instr;
+    this->execute(*instr, wid, trace);
+  }
 
   DP(5, "Register state:");
   for (uint32_t i = 0; i < arch_.num_regs(); ++i) {
     DPN(5, "  %r" << std::setfill('0') << std::setw(2) << std::dec << i << ':');
     // Integer register file
     for (uint32_t j = 0; j < arch_.num_threads(); ++j) {
-      DPN(5, ' ' << std::setfill('0') << std::setw(XLEN/4) << std::hex << warp.ireg_file.at(j).at(i) << std::setfill(' ') << ' ');
+      DPN(5, ' ' << std::setfill('0') << std::setw(XLEN/4) << std::hex << warp.ireg_file.at(j, i) << std::setfill(' ') << ' ');
     }
     DPN(5, '|');
     // Floating point register file
     for (uint32_t j = 0; j < arch_.num_threads(); ++j) {
-      DPN(5, ' ' << std::setfill('0') << std::setw(16) << std::hex << warp.freg_file.at(j).at(i) << std::setfill(' ') << ' ');
+      DPN(5, ' ' << std::setfill('0') << std::setw(16) << std::hex << warp.freg_file.at(j, i) << std::setfill(' ') << ' ');
     }
     DPN(5, std::endl);
   }
+}
 
-  return trace;
+#ifndef NDEBUG
+// debug builds check the decoded handlers against execute(),
+// memory accesses are not replayed.
+void Emulator::check_handler(const decode_entry_t& entry, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  auto opcode = entry.instr->getOpcode();
+  if (opcode == Opcode::L || opcode == Opcode::S) {
+    (this->*entry.handler)(entry, wid, trace);
+    return;
+  }
+
+  auto saved_warp = warp;
+  instr_trace_t ref_trace(*trace);
+  this->execute(*entry.instr, wid, &ref_trace);
+  auto ref_warp = warp;
+  warp = saved_warp;
+
+  (this->*entry.handler)(entry, wid, trace);
+
+  if (warp.PC != ref_warp.PC
+   || warp.tmask != ref_warp.tmask
+   || warp.ireg_file.data() != ref_warp.ireg_file.data()
+   || trace->PC != ref_trace.PC
+   || trace->tmask != ref_trace.tmask
+   || trace->rdest != ref_trace.rdest
+   || trace->rdest_type != ref_trace.rdest_type
+   || trace->wb != ref_trace.wb
+   || trace->used_iregs != ref_trace.used_iregs
+   || trace->used_fregs != ref_trace.used_fregs
+   || trace->fu_type != ref_trace.fu_type
+   || trace->unit_type != ref_trace.unit_type
+   || trace->fetch_stall != ref_trace.fetch_stall) {
+    std::cout << "Error: decoded handler mismatch at PC=0x" << std::hex << entry.PC << std::dec
+              << ": " << *entry.instr << std::endl;
+    std::abort();
+  }
+}
+#endif
+
+const Emulator::decode_entry_t& Emulator::fetch_decode(Word PC, uint64_t uuid) {
+  // a store may have modified the cached code
+  auto code_epoch = processor_->code_epoch();
+  if (code_epoch != code_epoch_) {
+    this->flush_decode_cache();
+    code_epoch_ = code_epoch;
+  }
+
+  auto& entry = decode_cache_.at((PC >> 2) & (DECODE_CACHE_SIZE-1));
+  if (entry.instr && entry.PC == PC)
+    return entry;
+
+  uint32_t instr_code = 0;
+  this->icache_read(&instr_code, PC, sizeof(uint32_t));
+
+  auto instr = this->decode(instr_code);
+  if (!instr) {
+    std::cout << std::hex << "Error: invalid instruction 0x" << instr_code << ", at PC=0x" << PC << " (#" << std::dec << uuid << ")" << std::endl;
+    std::abort();
+  }
+
+  entry.PC      = PC;
+  entry.code    = instr_code;
+  entry.instr   = instr;
+  entry.handler = this->translate(*instr);
+  entry.rd      = instr->getRDest();
+  entry.rs1     = instr->getRSrc(0);
+  entry.rs2     = instr->getRSrc(1);
+  entry.imm     = sext((Word)instr->getImm(), 32);
+
+  // track the cached code range for store invalidation
+  processor_->code_decoded(PC, PC + sizeof(uint32_t));
+  return entry;
+}
+
+void Emulator::flush_decode_cache() {
+  for (auto& entry : decode_cache_) {
+    entry.instr = nullptr;
+  }
 }
 
 bool Emulator::running() const {
@@ -207,7 +462,7 @@ bool Emulator::running() const {
 }
 
 int Emulator::get_exitcode() const {
-  return warps_.at(0).ireg_file.at(0).at(3);
+  return warps_.at(0).ireg_file.at(0, 3);
 }
 
 void Emulator::suspend(uint32_t wid) {
@@ -292,6 +547,8 @@ void Emulator::dcache_write(const void* data, uint64_t addr, uint32_t size) {
       core_->local_mem()->write(data, addr, size);
     } else {
       mmu_.write(data, addr, size, 0);
+      // self-modifying code, the decode caches are flushed on the next fetch
+      processor_->code_written(addr, size);
     }
   }
   DPH(2, "Mem Write: addr=0x" << std::hex << addr << ", data=0x" << ByteStream(data, size) << " (size=" << size << ", type=" << type << ")" << std::endl);
@@ -334,124 +591,147 @@ void Emulator::cout_flush() {
   }
 }
 
-#ifdef XLEN_64
-  #define CSR_READ_64(addr, value) \
-    case addr: return value
-#else
-  #define CSR_READ_64(addr, value) \
-    case addr : return (uint32_t)value; \
-    case (addr + (VX_CSR_MPM_BASE_H-VX_CSR_MPM_BASE)) : return ((value >> 32) & 0xFFFFFFFF)
+Emulator::csr_reader_t Emulator::csr_high(const csr_reader_t& reader) {
+  return [reader](uint32_t tid, uint32_t wid)->uint64_t {
+    return reader(tid, wid) >> 32;
+  };
+}
+
+void Emulator::map_csr(uint32_t addr, const csr_reader_t& reader) {
+  assert(csr_readers_.size() < 256);
+  csr_index_.at(addr) = csr_readers_.size();
+  csr_readers_.push_back(reader);
+}
+
+void Emulator::map_counter(std::vector<csr_reader_t>& readers, uint32_t addr, const csr_reader_t& reader) {
+  readers.at(addr - VX_CSR_MPM_BASE) = reader;
+#if (XLEN == 32)
+  readers.at(addr - VX_CSR_MPM_BASE + (VX_CSR_MPM_BASE_H-VX_CSR_MPM_BASE)) = csr_high(reader);
 #endif
+}
 
-Word Emulator::get_csr(uint32_t addr, uint32_t tid, uint32_t wid) {
-  auto core_perf = core_->perf_stats();
-  switch (addr) {
-  case VX_CSR_SATP:
-  case VX_CSR_PMPCFG0:
-  case VX_CSR_PMPADDR0:
-  case VX_CSR_MSTATUS:
-  case VX_CSR_MISA:
-  case VX_CSR_MEDELEG:
-  case VX_CSR_MIDELEG:
-  case VX_CSR_MIE:
-  case VX_CSR_MTVEC:
-  case VX_CSR_MEPC:
-  case VX_CSR_MNSTATUS:
-    return 0;
+void Emulator::init_csrs() {
+  // slot zero marks the unmapped addresses
+  csr_index_.resize(arch_.num_csrs(), 0);
+  csr_readers_.resize(1);
 
-  case VX_CSR_FFLAGS:     return warps_.at(wid).fcsr & 0x1F;
-  case VX_CSR_FRM:        return (warps_.at(wid).fcsr >> 5);
-  case VX_CSR_FCSR:       return warps_.at(wid).fcsr;
-  case VX_CSR_MHARTID:    return (core_->id() * arch_.num_warps() + wid) * arch_.num_threads() + tid;
-  case VX_CSR_THREAD_ID:  return tid;
-  case VX_CSR_WARP_ID:    return wid;
-  case VX_CSR_CORE_ID:    return core_->id();
-  case VX_CSR_ACTIVE_THREADS:return warps_.at(wid).tmask.to_ulong();
-  case VX_CSR_ACTIVE_WARPS:return active_warps_.to_ulong();
-  case VX_CSR_NUM_THREADS:return arch_.num_threads();
-  case VX_CSR_NUM_WARPS:  return arch_.num_warps();
-  case VX_CSR_NUM_CORES:  return uint32_t(arch_.num_cores()) * arch_.num_clusters();
-  case VX_CSR_NUM_BARRIERS:return arch_.num_barriers();
-  case VX_CSR_MSCRATCH:   return csr_mscratch_;
-  CSR_READ_64(VX_CSR_MCYCLE, core_perf.cycles);
-  CSR_READ_64(VX_CSR_MINSTRET, core_perf.instrs);
-  default:
-    if ((addr >= VX_CSR_MPM_BASE && addr < (VX_CSR_MPM_BASE + 32))
-     || (addr >= VX_CSR_MPM_BASE_H && addr < (VX_CSR_MPM_BASE_H + 32))) {
-      // user-defined MPM CSRs
-      auto perf_class = dcrs_.base_dcrs.read(VX_DCR_BASE_MPM_CLASS);
-      switch (perf_class) {
-      case VX_DCR_MPM_CLASS_NONE:
-        break;
-      case VX_DCR_MPM_CLASS_CORE: {
-        switch (addr) {
-        CSR_READ_64(VX_CSR_MPM_SCHED_ID, core_perf.sched_idle);
-        CSR_READ_64(VX_CSR_MPM_SCHED_ST, core_perf.sched_stalls);
-        CSR_READ_64(VX_CSR_MPM_IBUF_ST, core_perf.ibuf_stalls);
-        CSR_READ_64(VX_CSR_MPM_SCRB_ST, core_perf.scrb_stalls);
-        CSR_READ_64(VX_CSR_MPM_SCRB_ALU, core_perf.scrb_alu);
-        CSR_READ_64(VX_CSR_MPM_SCRB_FPU, core_perf.scrb_fpu);
-        CSR_READ_64(VX_CSR_MPM_SCRB_LSU, core_perf.scrb_lsu);
-        CSR_READ_64(VX_CSR_MPM_SCRB_SFU, core_perf.scrb_sfu);
-        CSR_READ_64(VX_CSR_MPM_SCRB_WCTL, core_perf.scrb_wctl);
-        CSR_READ_64(VX_CSR_MPM_SCRB_CSRS, core_perf.scrb_csrs);
-        CSR_READ_64(VX_CSR_MPM_IFETCHES, core_perf.ifetches);
-        CSR_READ_64(VX_CSR_MPM_LOADS, core_perf.loads);
-        CSR_READ_64(VX_CSR_MPM_STORES, core_perf.stores);
-        CSR_READ_64(VX_CSR_MPM_IFETCH_LT, core_perf.ifetch_latency);
-        CSR_READ_64(VX_CSR_MPM_LOAD_LT, core_perf.load_latency);
-        }
-      } break;
-      case VX_DCR_MPM_CLASS_MEM: {
-        auto proc_perf = core_->socket()->cluster()->processor()->perf_stats();
-        auto cluster_perf = core_->socket()->cluster()->perf_stats();
-        auto socket_perf = core_->socket()->perf_stats();
-        auto lmem_perf = core_->local_mem()->perf_stats();
-        switch (addr) {
-        CSR_READ_64(VX_CSR_MPM_ICACHE_READS, socket_perf.icache.reads);
-        CSR_READ_64(VX_CSR_MPM_ICACHE_MISS_R, socket_perf.icache.read_misses);
-        CSR_READ_64(VX_CSR_MPM_ICACHE_MSHR_ST, socket_perf.icache.mshr_stalls);
-
-        CSR_READ_64(VX_CSR_MPM_DCACHE_READS, socket_perf.dcache.reads);
-        CSR_READ_64(VX_CSR_MPM_DCACHE_WRITES, socket_perf.dcache.writes);
-        CSR_READ_64(VX_CSR_MPM_DCACHE_MISS_R, socket_perf.dcache.read_misses);
-        CSR_READ_64(VX_CSR_MPM_DCACHE_MISS_W, socket_perf.dcache.write_misses);
-        CSR_READ_64(VX_CSR_MPM_DCACHE_BANK_ST, socket_perf.dcache.bank_stalls);
-        CSR_READ_64(VX_CSR_MPM_DCACHE_MSHR_ST, socket_perf.dcache.mshr_stalls);
-
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_READS, cluster_perf.l2cache.reads);
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_WRITES, cluster_perf.l2cache.writes);
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_MISS_R, cluster_perf.l2cache.read_misses);
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_MISS_W, cluster_perf.l2cache.write_misses);
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_BANK_ST, cluster_perf.l2cache.bank_stalls);
-        CSR_READ_64(VX_CSR_MPM_L2CACHE_MSHR_ST, cluster_perf.l2cache.mshr_stalls);
-
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_READS, proc_perf.l3cache.reads);
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_WRITES, proc_perf.l3cache.writes);
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_MISS_R, proc_perf.l3cache.read_misses);
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_MISS_W, proc_perf.l3cache.write_misses);
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_BANK_ST, proc_perf.l3cache.bank_stalls);
-        CSR_READ_64(VX_CSR_MPM_L3CACHE_MSHR_ST, proc_perf.l3cache.mshr_stalls);
-
-        CSR_READ_64(VX_CSR_MPM_MEM_READS, proc_perf.mem_reads);
-        CSR_READ_64(VX_CSR_MPM_MEM_WRITES, proc_perf.mem_writes);
-        CSR_READ_64(VX_CSR_MPM_MEM_LT, proc_perf.mem_latency);
-
-        CSR_READ_64(VX_CSR_MPM_LMEM_READS, lmem_perf.reads);
-        CSR_READ_64(VX_CSR_MPM_LMEM_WRITES, lmem_perf.writes);
-        CSR_READ_64(VX_CSR_MPM_LMEM_BANK_ST, lmem_perf.bank_stalls);
-        }
-      } break;
-      default: {
-        std::cout << std::dec << "Error: invalid MPM CLASS: value=" << perf_class << std::endl;
-        std::abort();
-      } break;
-      }
-    } else {
-      std::cout << std::hex << "Error: invalid CSR read addr=0x" << addr << std::endl;
+  auto zero = [](uint32_t, uint32_t)->uint64_t { return 0; };
+  for (auto addr : {VX_CSR_SATP, VX_CSR_PMPCFG0, VX_CSR_PMPADDR0, VX_CSR_MSTATUS, VX_CSR_MISA,
+                    VX_CSR_MEDELEG, VX_CSR_MIDELEG, VX_CSR_MIE, VX_CSR_MTVEC, VX_CSR_MEPC,
+                    VX_CSR_MNSTATUS, VX_CSR_SIM_REGION}) {
+    this->map_csr(addr, zero);
+  }
+
+  this->map_csr(VX_CSR_FFLAGS, [this](uint32_t, uint32_t wid)->uint64_t { return warps_.at(wid).fcsr & 0x1F; });
+  this->map_csr(VX_CSR_FRM, [this](uint32_t, uint32_t wid)->uint64_t { return (warps_.at(wid).fcsr >> 5); });
+  this->map_csr(VX_CSR_FCSR, [this](uint32_t, uint32_t wid)->uint64_t { return warps_.at(wid).fcsr; });
+  this->map_csr(VX_CSR_MHARTID, [this](uint32_t tid, uint32_t wid)->uint64_t { return (core_->id() * arch_.num_warps() + wid) * arch_.num_threads() + tid; });
+  this->map_csr(VX_CSR_THREAD_ID, [](uint32_t tid, uint32_t)->uint64_t { return tid; });
+  this->map_csr(VX_CSR_WARP_ID, [](uint32_t, uint32_t wid)->uint64_t { return wid; });
+  this->map_csr(VX_CSR_CORE_ID, [this](uint32_t, uint32_t)->uint64_t { return core_->id(); });
+  this->map_csr(VX_CSR_ACTIVE_THREADS, [this](uint32_t, uint32_t wid)->uint64_t { return warps_.at(wid).tmask.to_ulong(); });
+  this->map_csr(VX_CSR_ACTIVE_WARPS, [this](uint32_t, uint32_t)->uint64_t { return active_warps_.to_ulong(); });
+  this->map_csr(VX_CSR_NUM_THREADS, [this](uint32_t, uint32_t)->uint64_t { return arch_.num_threads(); });
+  this->map_csr(VX_CSR_NUM_WARPS, [this](uint32_t, uint32_t)->uint64_t { return arch_.num_warps(); });
+  this->map_csr(VX_CSR_NUM_CORES, [this](uint32_t, uint32_t)->uint64_t { return uint32_t(arch_.num_cores()) * arch_.num_clusters(); });
+  this->map_csr(VX_CSR_NUM_BARRIERS, [this](uint32_t, uint32_t)->uint64_t { return arch_.num_barriers(); });
+  this->map_csr(VX_CSR_MSCRATCH, [this](uint32_t, uint32_t)->uint64_t { return csr_mscratch_; });
+
+  csr_reader_t mcycle = [this](uint32_t, uint32_t)->uint64_t { return core_->perf_stats().cycles; };
+  csr_reader_t minstret = [this](uint32_t, uint32_t)->uint64_t { return core_->perf_stats().instrs; };
+  this->map_csr(VX_CSR_MCYCLE, mcycle);
+  this->map_csr(VX_CSR_MINSTRET, minstret);
+#if (XLEN == 32)
+  this->map_csr(VX_CSR_MCYCLE_H, csr_high(mcycle));
+  this->map_csr(VX_CSR_MINSTRET_H, csr_high(minstret));
+#endif
+
+  // user-defined MPM CSRs, one table per MPM class indexed from VX_CSR_MPM_BASE,
+  // each counter only queries the unit that owns it.
+  mpm_readers_.resize(VX_DCR_MPM_CLASS_MEM + 1);
+  for (auto& readers : mpm_readers_) {
+    readers.resize(VX_CSR_MPM_BASE_H + 32 - VX_CSR_MPM_BASE);
+  }
+
+  #define CORE_COUNTER(addr, counter) \
+    this->map_counter(core, addr, [this](uint32_t, uint32_t)->uint64_t { return core_->perf_stats().counter; })
+  auto& core = mpm_readers_.at(VX_DCR_MPM_CLASS_CORE);
+  CORE_COUNTER(VX_CSR_MPM_SCHED_ID, sched_idle);
+  CORE_COUNTER(VX_CSR_MPM_SCHED_ST, sched_stalls);
+  CORE_COUNTER(VX_CSR_MPM_IBUF_ST, ibuf_stalls);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_ST, scrb_stalls);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_ALU, scrb_alu);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_FPU, scrb_fpu);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_LSU, scrb_lsu);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_SFU, scrb_sfu);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_WCTL, scrb_wctl);
+  CORE_COUNTER(VX_CSR_MPM_SCRB_CSRS, scrb_csrs);
+  CORE_COUNTER(VX_CSR_MPM_IFETCHES, ifetches);
+  CORE_COUNTER(VX_CSR_MPM_LOADS, loads);
+  CORE_COUNTER(VX_CSR_MPM_STORES, stores);
+  CORE_COUNTER(VX_CSR_MPM_IFETCH_LT, ifetch_latency);
+  CORE_COUNTER(VX_CSR_MPM_LOAD_LT, load_latency);
+  #undef CORE_COUNTER
+
+  #define MEM_COUNTER(addr, unit, counter) \
+    this->map_counter(mem, addr, [this](uint32_t, uint32_t)->uint64_t { return unit->perf_stats().counter; })
+  auto& mem = mpm_readers_.at(VX_DCR_MPM_CLASS_MEM);
+  MEM_COUNTER(VX_CSR_MPM_ICACHE_READS, core_->socket(), icache.reads);
+  MEM_COUNTER(VX_CSR_MPM_ICACHE_MISS_R, core_->socket(), icache.read_misses);
+  MEM_COUNTER(VX_CSR_MPM_ICACHE_MSHR_ST, core_->socket(), icache.mshr_stalls);
+
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_READS, core_->socket(), dcache.reads);
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_WRITES, core_->socket(), dcache.writes);
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_MISS_R, core_->socket(), dcache.read_misses);
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_MISS_W, core_->socket(), dcache.write_misses);
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_BANK_ST, core_->socket(), dcache.bank_stalls);
+  MEM_COUNTER(VX_CSR_MPM_DCACHE_MSHR_ST, core_->socket(), dcache.mshr_stalls);
+
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_READS, core_->socket()->cluster(), l2cache.reads);
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_WRITES, core_->socket()->cluster(), l2cache.writes);
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_MISS_R, core_->socket()->cluster(), l2cache.read_misses);
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_MISS_W, core_->socket()->cluster(), l2cache.write_misses);
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_BANK_ST, core_->socket()->cluster(), l2cache.bank_stalls);
+  MEM_COUNTER(VX_CSR_MPM_L2CACHE_MSHR_ST, core_->socket()->cluster(), l2cache.mshr_stalls);
+
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_READS, core_->socket()->cluster()->processor(), l3cache.reads);
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_WRITES, core_->socket()->cluster()->processor(), l3cache.writes);
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_MISS_R, core_->socket()->cluster()->processor(), l3cache.read_misses);
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_MISS_W, core_->socket()->cluster()->processor(), l3cache.write_misses);
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_BANK_ST, core_->socket()->cluster()->processor(), l3cache.bank_stalls);
+  MEM_COUNTER(VX_CSR_MPM_L3CACHE_MSHR_ST, core_->socket()->cluster()->processor(), l3cache.mshr_stalls);
+
+  MEM_COUNTER(VX_CSR_MPM_MEM_READS, core_->socket()->cluster()->processor(), mem_reads);
+  MEM_COUNTER(VX_CSR_MPM_MEM_WRITES, core_->socket()->cluster()->processor(), mem_writes);
+  MEM_COUNTER(VX_CSR_MPM_MEM_LT, core_->socket()->cluster()->processor(), mem_latency);
+  this->map_counter(mem, VX_CSR_MPM_AMOS, [this](uint32_t, uint32_t)->uint64_t { return processor_->perf_amos(); });
+  this->map_counter(mem, VX_CSR_MPM_AMO_ST, [this](uint32_t, uint32_t)->uint64_t { return processor_->perf_amo_stalls(); });
+
+  MEM_COUNTER(VX_CSR_MPM_LMEM_READS, core_->local_mem(), reads);
+  MEM_COUNTER(VX_CSR_MPM_LMEM_WRITES, core_->local_mem(), writes);
+  MEM_COUNTER(VX_CSR_MPM_LMEM_BANK_ST, core_->local_mem(), bank_stalls);
+  #undef MEM_COUNTER
+}
+
+Word Emulator::get_csr(uint32_t addr, uint32_t tid, uint32_t wid) {
+  auto index = csr_index_.at(addr);
+  if (index != 0)
+    return csr_readers_[index](tid, wid);
+  if ((addr >= VX_CSR_MPM_BASE && addr < (VX_CSR_MPM_BASE + 32))
+   || (addr >= VX_CSR_MPM_BASE_H && addr < (VX_CSR_MPM_BASE_H + 32))) {
+    // user-defined MPM CSRs
+    auto perf_class = dcrs_.base_dcrs.read(VX_DCR_BASE_MPM_CLASS);
+    if (perf_class >= mpm_readers_.size()) {
+      std::cout << std::dec << "Error: invalid MPM CLASS: value=" << perf_class << std::endl;
       std::abort();
     }
+    auto& mpm_reader = mpm_readers_.at(perf_class).at(addr - VX_CSR_MPM_BASE);
+    if (mpm_reader)
+      return mpm_reader(tid, wid);
+    return 0;
   }
+  std::cout << std::hex << "Error: invalid CSR read addr=0x" << addr << std::endl;
+  std::abort();
   return 0;
 }
 
@@ -470,6 +750,9 @@ void Emulator::set_csr(uint32_t addr, Word value, uint32_t tid, uint32_t wid) {
   case VX_CSR_MSCRATCH:
     csr_mscratch_ = value;
     break;
+  case VX_CSR_SIM_REGION:
+    core_->socket()->cluster()->processor()->region_marker(value != 0);
+    break;
   case VX_CSR_SATP:
   case VX_CSR_MSTATUS:
   case VX_CSR_MEDELEG:
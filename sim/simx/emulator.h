@@ -15,8 +15,10 @@
 #define __WARP_H
 
 #include <vector>
+#include <algorithm>
 #include <sstream>
 #include <stack>
+#include <functional>
 #include <mem.h>
 #include "types.h"
 
@@ -25,11 +27,18 @@ namespace vortex {
 class Arch;
 class DCRS;
 class Core;
+class ProcessorImpl;
 class Instr;
 class instr_trace_t;
 
 class Emulator {
 public:
+  struct mem_access_t {
+    uint64_t addr;
+    bool     write;
+    bool     ifetch;
+  };
+
   Emulator(const Arch &arch,
            const DCRS &dcrs,
            Core* core);
@@ -40,7 +49,22 @@ public:
 
   void attach_ram(RAM* ram);
 
-  instr_trace_t* step();
+  // mask of the warps ready to issue
+  uint64_t ready_warps();
+
+  // execute the next instruction of the given warp
+  instr_trace_t* step(uint32_t wid);
+
+  // execute the next instruction without timing,
+  // returns the number of active threads or zero if no warp is ready.
+  uint32_t step_functional();
+
+  // hybrid mode: flag the processor when functional execution reaches
+  // start_pc and keep the last window_size memory accesses for cache warming.
+  void set_region(Word start_pc, uint32_t window_size);
+
+  // recorded memory accesses, oldest first
+  std::vector<mem_access_t> access_window() const;
 
   bool running() const;
 
@@ -54,6 +78,11 @@ public:
 
   int get_exitcode() const;
 
+  // checkpoint the warps' architectural state
+  void save(std::ostream& os) const;
+
+  void load(std::istream& is);
+
 private:
 
   struct ipdom_entry_t {
@@ -65,29 +94,144 @@ private:
     bool        fallthrough;
   };
 
+  // register-major storage, the lanes of a register are contiguous
+  // and padded to whole blocks so that lane loops map to SIMD registers.
+  template <typename T>
+  class reg_file_t {
+  public:
+    enum { BLOCK_SIZE = 4 };
+
+    reg_file_t(uint32_t num_regs, uint32_t num_lanes)
+      : stride_((num_lanes + BLOCK_SIZE - 1) & ~(BLOCK_SIZE - 1))
+      , data_(num_regs * stride_, 0)
+    {}
+
+    uint32_t stride() const {
+      return stride_;
+    }
+
+    T* lanes(uint32_t reg) {
+      return data_.data() + reg * stride_;
+    }
+
+    const T* lanes(uint32_t reg) const {
+      return data_.data() + reg * stride_;
+    }
+
+    T& at(uint32_t lane, uint32_t reg) {
+      return data_.at(reg * stride_ + lane);
+    }
+
+    const T& at(uint32_t lane, uint32_t reg) const {
+      return data_.at(reg * stride_ + lane);
+    }
+
+    void clear() {
+      std::fill(data_.begin(), data_.end(), 0);
+    }
+
+    std::vector<T>& data() {
+      return data_;
+    }
+
+    const std::vector<T>& data() const {
+      return data_;
+    }
+
+  private:
+    uint32_t stride_;
+    std::vector<T> data_;
+  };
+
   struct warp_t {
     warp_t(const Arch& arch);
     void clear(uint64_t startup_addr);
 
     Word                              PC;
     ThreadMask                        tmask;
-    std::vector<std::vector<Word>>    ireg_file;
-    std::vector<std::vector<uint64_t>>freg_file;
+    reg_file_t<Word>                  ireg_file;
+    reg_file_t<uint64_t>              freg_file;
     std::stack<ipdom_entry_t>         ipdom_stack;
     Byte                              fcsr;
     UUIDGenerator                     uui_gen;
   };
 
+  struct decode_entry_t;
+
+  // pre-decoded instruction handler, see translate.cpp
+  typedef void (Emulator::*uop_handler_t)(const decode_entry_t&, uint32_t, instr_trace_t*);
+
+  struct decode_entry_t {
+    Word                   PC;
+    uint32_t               code;
+    std::shared_ptr<Instr> instr;
+    uop_handler_t          handler;
+    uint32_t               rd;
+    uint32_t               rs1;
+    uint32_t               rs2;
+    Word                   imm;
+  };
+
+  // CSR read handler, counters return their full 64-bit value
+  typedef std::function<uint64_t (uint32_t tid, uint32_t wid)> csr_reader_t;
+
   struct wspawn_t {
     bool valid;
     uint32_t num_warps;
     Word nextPC;
   };
 
+  int schedule_warp(uint32_t start_wid);
+
+  uint64_t get_uuid(uint32_t wid);
+
+  void fetch_execute(uint32_t wid, instr_trace_t* trace);
+
+  void record_accesses(const instr_trace_t& trace);
+
   std::shared_ptr<Instr> decode(uint32_t code) const;
 
+  const decode_entry_t& fetch_decode(Word PC, uint64_t uuid);
+
+  void flush_decode_cache();
+
   void execute(const Instr &instr, uint32_t wid, instr_trace_t *trace);
 
+  // select a dedicated handler for the common integer instructions,
+  // returns nullptr for the ones left to execute().
+  uop_handler_t translate(const Instr &instr) const;
+
+  // runs a handler and compares it with execute(), debug builds only
+  void check_handler(const decode_entry_t& entry, uint32_t wid, instr_trace_t* trace);
+
+  void uop_trace(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  void uop_write(uint32_t reg, Word value, warp_t& warp);
+
+  void uop_addrs(const decode_entry_t& uop, warp_t& warp, Word* addrs);
+
+  template <typename Op, bool Imm>
+  void uop_alu(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  template <bool PCRel>
+  void uop_upper(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  template <typename Cmp>
+  void uop_branch(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  void uop_jal(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  void uop_jalr(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  template <typename T>
+  void uop_load(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  template <typename T>
+  void uop_store(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
+  template <typename Csr>
+  void uop_csr_id(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace);
+
   void icache_read(void* data, uint64_t addr, uint32_t size);
 
   void dcache_read(void* data, uint64_t addr, uint32_t size);
@@ -102,6 +246,15 @@ private:
 
   void cout_flush();
 
+  void init_csrs();
+
+  void map_csr(uint32_t addr, const csr_reader_t& reader);
+
+  void map_counter(std::vector<csr_reader_t>& readers, uint32_t addr, const csr_reader_t& reader);
+
+  // reads the upper half of a 64-bit counter on RV32
+  static csr_reader_t csr_high(const csr_reader_t& reader);
+
   Word get_csr(uint32_t addr, uint32_t tid, uint32_t wid);
 
   void set_csr(uint32_t addr, Word value, uint32_t tid, uint32_t wid);
@@ -125,6 +278,18 @@ private:
   MemoryUnit  mmu_;
   Word        csr_mscratch_;
   wspawn_t    wspawn_;
+  uint32_t    functional_wid_;
+  Word        region_pc_;
+  std::vector<mem_access_t> access_window_;
+  uint32_t    access_head_;
+  uint32_t    access_size_;
+  uint64_t    last_fetch_line_;
+  std::vector<decode_entry_t> decode_cache_;
+  ProcessorImpl* processor_;
+  uint64_t    code_epoch_;
+  std::vector<uint8_t> csr_index_;
+  std::vector<csr_reader_t> csr_readers_;
+  std::vector<std::vector<csr_reader_t>> mpm_readers_;
 };
 
 }
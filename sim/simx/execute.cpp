@@ -94,8 +94,8 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         break;
   }
 
-  std::vector<reg_data_t[3]> rsdata(num_threads);
-  std::vector<reg_data_t> rddata(num_threads);
+  reg_data_t rsdata[MAX_NUM_THREADS][3] = {};
+  reg_data_t rddata[MAX_NUM_THREADS] = {};
 
   auto num_rsrcs = instr.getNRSrc();
   if (num_rsrcs) {
@@ -111,7 +111,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
             DPN(2, "-");
             continue;
           }
-          rsdata[t][i].u = warp.ireg_file.at(t)[reg];
+          rsdata[t][i].u = warp.ireg_file.at(t, reg);
           DPN(2, "0x" << std::hex << rsdata[t][i].i);
         }
         DPN(2, "}" << std::endl);
@@ -124,7 +124,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
             DPN(2, "-");
             continue;
           }
-          rsdata[t][i].u64 = warp.freg_file.at(t)[reg];
+          rsdata[t][i].u64 = warp.freg_file.at(t, reg);
           DPN(2, "0x" << std::hex << rsdata[t][i].f);
         }
         DPN(2, "}" << std::endl);
@@ -186,7 +186,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           std::abort();
         }
       } else
-      if (func7 & 0x1) {
+      if (func7 == 0x1) {
         switch (func3) {
         case 0: {
           // RV32M: MUL
@@ -275,6 +275,86 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         default:
           std::abort();
         }
+      } else
+      if (func7 != 0x0 && func7 != 0x20) {
+        auto shamt = rsdata[t][1].u & (XLEN-1);
+        switch (func7) {
+        case 0x04: {
+          // ZBB: ZEXT.H
+          assert(func3 == 4);
+          rddata[t].u = rsdata[t][0].u & 0xffff;
+          break;
+        }
+        case 0x05: {
+          switch (func3) {
+          case 4: {
+            // ZBB: MIN
+            rddata[t].i = std::min(rsdata[t][0].i, rsdata[t][1].i);
+            break;
+          }
+          case 5: {
+            // ZBB: MINU
+            rddata[t].u = std::min(rsdata[t][0].u, rsdata[t][1].u);
+            break;
+          }
+          case 6: {
+            // ZBB: MAX
+            rddata[t].i = std::max(rsdata[t][0].i, rsdata[t][1].i);
+            break;
+          }
+          case 7: {
+            // ZBB: MAXU
+            rddata[t].u = std::max(rsdata[t][0].u, rsdata[t][1].u);
+            break;
+          }
+          default:
+            std::abort();
+          }
+          break;
+        }
+        case 0x10: {
+          // ZBA: SH1ADD, SH2ADD, SH3ADD
+          assert(func3 == 2 || func3 == 4 || func3 == 6);
+          rddata[t].u = (rsdata[t][0].u << (func3 >> 1)) + rsdata[t][1].u;
+          break;
+        }
+        case 0x14: {
+          // ZBS: BSET
+          assert(func3 == 1);
+          rddata[t].u = rsdata[t][0].u | (Word(1) << shamt);
+          break;
+        }
+        case 0x24: {
+          if (func3 == 1) {
+            // ZBS: BCLR
+            rddata[t].u = rsdata[t][0].u & ~(Word(1) << shamt);
+          } else {
+            // ZBS: BEXT
+            assert(func3 == 5);
+            rddata[t].u = (rsdata[t][0].u >> shamt) & 0x1;
+          }
+          break;
+        }
+        case 0x30: {
+          if (func3 == 1) {
+            // ZBB: ROL
+            rddata[t].u = rotate_left(rsdata[t][0].u, shamt);
+          } else {
+            // ZBB: ROR
+            assert(func3 == 5);
+            rddata[t].u = rotate_right(rsdata[t][0].u, shamt);
+          }
+          break;
+        }
+        case 0x34: {
+          // ZBS: BINV
+          assert(func3 == 1);
+          rddata[t].u = rsdata[t][0].u ^ (Word(1) << shamt);
+          break;
+        }
+        default:
+          std::abort();
+        }
       } else {
         switch (func3) {
         case 0: {
@@ -305,8 +385,13 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           break;
         }
         case 4: {
-          // RV32I: XOR
-          rddata[t].i = rsdata[t][0].i ^ rsdata[t][1].i;
+          if (func7 & 0x20) {
+            // ZBB: XNOR
+            rddata[t].i = ~(rsdata[t][0].i ^ rsdata[t][1].i);
+          } else {
+            // RV32I: XOR
+            rddata[t].i = rsdata[t][0].i ^ rsdata[t][1].i;
+          }
           break;
         }
         case 5: {
@@ -322,13 +407,23 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           break;
         }
         case 6: {
-          // RV32I: OR
-          rddata[t].i = rsdata[t][0].i | rsdata[t][1].i;
+          if (func7 & 0x20) {
+            // ZBB: ORN
+            rddata[t].i = rsdata[t][0].i | ~rsdata[t][1].i;
+          } else {
+            // RV32I: OR
+            rddata[t].i = rsdata[t][0].i | rsdata[t][1].i;
+          }
           break;
         }
         case 7: {
-          // RV32I: AND
-          rddata[t].i = rsdata[t][0].i & rsdata[t][1].i;
+          if (func7 & 0x20) {
+            // ZBB: ANDN
+            rddata[t].i = rsdata[t][0].i & ~rsdata[t][1].i;
+          } else {
+            // RV32I: AND
+            rddata[t].i = rsdata[t][0].i & rsdata[t][1].i;
+          }
           break;
         }
         default:
@@ -353,8 +448,62 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         break;
       }
       case 1: {
-        // RV32I: SLLI
-        rddata[t].i = rsdata[t][0].i << immsrc;
+        switch (func7 & ~0x1) {
+        case 0x00: {
+          // RV32I: SLLI
+          rddata[t].i = rsdata[t][0].i << immsrc;
+          break;
+        }
+        case 0x14: {
+          // ZBS: BSETI
+          rddata[t].u = rsdata[t][0].u | (Word(1) << immsrc);
+          break;
+        }
+        case 0x24: {
+          // ZBS: BCLRI
+          rddata[t].u = rsdata[t][0].u & ~(Word(1) << immsrc);
+          break;
+        }
+        case 0x34: {
+          // ZBS: BINVI
+          rddata[t].u = rsdata[t][0].u ^ (Word(1) << immsrc);
+          break;
+        }
+        case 0x30: {
+          switch (immsrc) {
+          case 0: {
+            // ZBB: CLZ
+            rddata[t].u = count_leading_zeros(rsdata[t][0].u);
+            break;
+          }
+          case 1: {
+            // ZBB: CTZ
+            rddata[t].u = count_trailing_zeros(rsdata[t][0].u);
+            break;
+          }
+          case 2: {
+            // ZBB: CPOP
+            rddata[t].u = count_ones(rsdata[t][0].u);
+            break;
+          }
+          case 4: {
+            // ZBB: SEXT.B
+            rddata[t].u = sext(rsdata[t][0].u, 8);
+            break;
+          }
+          case 5: {
+            // ZBB: SEXT.H
+            rddata[t].u = sext(rsdata[t][0].u, 16);
+            break;
+          }
+          default:
+            std::abort();
+          }
+          break;
+        }
+        default:
+          std::abort();
+        }
         break;
       }
       case 2: {
@@ -373,14 +522,43 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         break;
       }
       case 5: {
-        if (func7 & 0x20) {
-          // RV32I: SRAI
-          Word result = rsdata[t][0].i >> immsrc;
-          rddata[t].i = result;
-        } else {
+        switch (func7 & ~0x1) {
+        case 0x00: {
           // RV32I: SRLI
           Word result = rsdata[t][0].u >> immsrc;
-          rddata[t].i = result;
+          rddata[t].u = result;
+          break;
+        }
+        case 0x20: {
+          // RV32I: SRAI
+          Word result = rsdata[t][0].i >> immsrc;
+          rddata[t].u = result;
+          break;
+        }
+        case 0x14: {
+          // ZBB: ORC.B
+          assert(immsrc == 0x7);
+          rddata[t].u = or_combine_bytes(rsdata[t][0].u);
+          break;
+        }
+        case 0x24: {
+          // ZBS: BEXTI
+          rddata[t].u = (rsdata[t][0].u >> immsrc) & 0x1;
+          break;
+        }
+        case 0x30: {
+          // ZBB: RORI
+          rddata[t].u = rotate_right(rsdata[t][0].u, immsrc);
+          break;
+        }
+        case 0x34: {
+          // ZBB: REV8
+          assert(immsrc == (XLEN - 8));
+          rddata[t].u = byte_swap(rsdata[t][0].u);
+          break;
+        }
+        default:
+          std::abort();
         }
         break;
       }
@@ -481,6 +659,44 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           default:
             std::abort();
         }
+      } else
+      if (func7 != 0x0 && func7 != 0x20) {
+        uint64_t first = (uint32_t)rsdata[t][0].i;
+        switch (func7) {
+        case 0x04: {
+          if (func3 == 0) {
+            // ZBA: ADD.UW
+            rddata[t].i = first + rsdata[t][1].i;
+          } else {
+            // ZBB: ZEXT.H
+            assert(func3 == 4);
+            rddata[t].i = first & 0xffff;
+          }
+          break;
+        }
+        case 0x10: {
+          // ZBA: SH1ADD.UW, SH2ADD.UW, SH3ADD.UW
+          assert(func3 == 2 || func3 == 4 || func3 == 6);
+          rddata[t].i = (first << (func3 >> 1)) + rsdata[t][1].i;
+          break;
+        }
+        case 0x30: {
+          uint32_t shamt = rsdata[t][1].i & 0x1F;
+          uint32_t result;
+          if (func3 == 1) {
+            // ZBB: ROLW
+            result = rotate_left((uint32_t)first, shamt);
+          } else {
+            // ZBB: RORW
+            assert(func3 == 5);
+            result = rotate_right((uint32_t)first, shamt);
+          }
+          rddata[t].i = sext((uint64_t)result, 32);
+          break;
+        }
+        default:
+          std::abort();
+        }
       } else {
         switch (func3) {
         case 0: {
@@ -541,6 +757,35 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           break;
         }
         case 1: {
+          if ((func7 & ~0x1) == 0x04) {
+            // ZBA: SLLI.UW
+            uint64_t first = (uint32_t)rsdata[t][0].i;
+            rddata[t].i = first << immsrc;
+            break;
+          }
+          if (func7 == 0x30) {
+            uint32_t first = rsdata[t][0].i;
+            switch (immsrc) {
+            case 0: {
+              // ZBB: CLZW
+              rddata[t].i = count_leading_zeros(first);
+              break;
+            }
+            case 1: {
+              // ZBB: CTZW
+              rddata[t].i = count_trailing_zeros(first);
+              break;
+            }
+            case 2: {
+              // ZBB: CPOPW
+              rddata[t].i = count_ones(first);
+              break;
+            }
+            default:
+              std::abort();
+            }
+            break;
+          }
           // RV64I: SLLIW
           uint32_t shamt_mask = 0x1F;
           uint32_t shamt = immsrc & shamt_mask;
@@ -552,6 +797,10 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           uint32_t shamt_mask = 0x1F;
           uint32_t shamt = immsrc & shamt_mask;
           uint32_t result;
+          if (func7 == 0x30) {
+            // ZBB: RORIW
+            result = rotate_right((uint32_t)rsdata[t][0].i, shamt);
+          } else
           if (func7 & 0x20) {
             // RV64I: SRAIW
             result = (int32_t)rsdata[t][0].i >> shamt;
@@ -677,7 +926,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
     trace->fu_type = FUType::LSU;
     trace->lsu_type = LsuType::LOAD;
     trace->used_iregs.set(rsrc0);
-    auto trace_data = std::make_shared<LsuTraceData>(num_threads);
+    auto trace_data = core_->trace_arena().make_data<LsuTraceData>();
     trace->data = trace_data;
     uint32_t data_bytes = 1 << (func3 & 0x3);
     uint32_t data_width = 8 * data_bytes;
@@ -722,7 +971,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
     trace->lsu_type = LsuType::STORE;
     trace->used_iregs.set(rsrc0);
     trace->used_iregs.set(rsrc1);
-    auto trace_data = std::make_shared<LsuTraceData>(num_threads);
+    auto trace_data = core_->trace_arena().make_data<LsuTraceData>();
     trace->data = trace_data;
     uint32_t data_bytes = 1 << (func3 & 0x3);
     for (uint32_t t = thread_start; t < num_threads; ++t) {
@@ -749,9 +998,24 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
     trace->lsu_type = LsuType::LOAD;
     trace->used_iregs.set(rsrc0);
     trace->used_iregs.set(rsrc1);
-    auto trace_data = std::make_shared<LsuTraceData>(num_threads);
+    auto trace_data = core_->trace_arena().make_data<LsuTraceData>();
     trace->data = trace_data;
     auto amo_type = func7 >> 2;
+    switch (amo_type) {
+    case 0x00: trace_data->amo_type = AmoType::ADD; break;
+    case 0x01: trace_data->amo_type = AmoType::SWAP; break;
+    case 0x02: trace_data->amo_type = AmoType::LR; break;
+    case 0x03: trace_data->amo_type = AmoType::SC; break;
+    case 0x04: trace_data->amo_type = AmoType::XOR; break;
+    case 0x08: trace_data->amo_type = AmoType::OR; break;
+    case 0x0c: trace_data->amo_type = AmoType::AND; break;
+    case 0x10: trace_data->amo_type = AmoType::MIN; break;
+    case 0x14: trace_data->amo_type = AmoType::MAX; break;
+    case 0x18: trace_data->amo_type = AmoType::MINU; break;
+    case 0x1c: trace_data->amo_type = AmoType::MAXU; break;
+    default:
+      std::abort();
+    }
     uint32_t data_bytes = 1 << (func3 & 0x3);
     uint32_t data_width = 8 * data_bytes;
     for (uint32_t t = thread_start; t < num_threads; ++t) {
@@ -1312,7 +1576,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         trace->fetch_stall = true;
         next_tmask.reset();
         for (uint32_t t = 0; t < num_threads; ++t) {
-          next_tmask.set(t, rsdata.at(thread_last)[0].i & (1 << t));
+          next_tmask.set(t, rsdata[thread_last][0].i & (1 << t));
         }
       } break;
       case 1: {
@@ -1322,7 +1586,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         trace->used_iregs.set(rsrc0);
         trace->used_iregs.set(rsrc1);
         trace->fetch_stall = true;
-        trace->data = std::make_shared<SFUTraceData>(rsdata.at(thread_last)[0].i, rsdata.at(thread_last)[1].i);
+        trace->data = core_->trace_arena().make_data<SFUTraceData>(rsdata[thread_last][0].i, rsdata[thread_last][1].i);
       } break;
       case 2: {
         // SPLIT
@@ -1336,7 +1600,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         ThreadMask then_tmask, else_tmask;
         auto not_pred = rsrc2 & 0x1;
         for (uint32_t t = 0; t < num_threads; ++t) {
-          auto cond = (warp.ireg_file.at(t).at(rsrc0) & 0x1) ^ not_pred;
+          auto cond = (warp.ireg_file.at(t, rsrc0) & 0x1) ^ not_pred;
           then_tmask[t] = warp.tmask.test(t) && cond;
           else_tmask[t] = warp.tmask.test(t) && !cond;
         }
@@ -1372,7 +1636,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         trace->used_iregs.set(rsrc0);
         trace->fetch_stall = true;
 
-        auto stack_ptr = warp.ireg_file.at(thread_last).at(rsrc0);
+        auto stack_ptr = warp.ireg_file.at(thread_last, rsrc0);
         if (stack_ptr != warp.ipdom_stack.size()) {
           if (warp.ipdom_stack.empty()) {
             std::cout << "IPDOM stack is empty!\n" << std::flush;
@@ -1392,7 +1656,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         trace->used_iregs.set(rsrc0);
         trace->used_iregs.set(rsrc1);
         trace->fetch_stall = true;
-        trace->data = std::make_shared<SFUTraceData>(rsdata[thread_last][0].i, rsdata[thread_last][1].i);
+        trace->data = core_->trace_arena().make_data<SFUTraceData>(rsdata[thread_last][0].i, rsdata[thread_last][1].i);
       } break;
       case 5: {
         // PRED
@@ -1404,13 +1668,13 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
         ThreadMask pred;
         auto not_pred = rdest & 0x1;
         for (uint32_t t = 0; t < num_threads; ++t) {
-          auto cond = (warp.ireg_file.at(t).at(rsrc0) & 0x1) ^ not_pred;
+          auto cond = (warp.ireg_file.at(t, rsrc0) & 0x1) ^ not_pred;
           pred[t] = warp.tmask.test(t) && cond;
         }
         if (pred.any()) {
           next_tmask &= pred;
         } else {
-          next_tmask = warp.ireg_file.at(thread_last).at(rsrc1);
+          next_tmask = warp.ireg_file.at(thread_last, rsrc1);
         }
       } break;
       default:
@@ -1421,6 +1685,74 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
       std::abort();
     }
   } break;
+  case Opcode::EXT3: {
+    trace->fu_type = FUType::SFU;
+    trace->used_iregs.set(rsrc0);
+    switch (func3) {
+    case 0: {
+      // SHFL.IDX, SHFL.UP, SHFL.DOWN, SHFL.XOR
+      // out-of-range or inactive source lanes return the lane's own value.
+      trace->sfu_type = SfuType::SHFL;
+      trace->used_iregs.set(rsrc1);
+      for (uint32_t t = thread_start; t < num_threads; ++t) {
+        if (!warp.tmask.test(t))
+          continue;
+        auto arg = rsdata[t][1].u;
+        Word src;
+        switch (func7) {
+        case 0: src = arg; break;
+        case 1: src = (arg <= t) ? (t - arg) : num_threads; break;
+        case 2: src = t + arg; break;
+        case 3: src = t ^ arg; break;
+        default:
+          std::abort();
+        }
+        if (src < num_threads && warp.tmask.test(src)) {
+          rddata[t].i = rsdata[src][0].i;
+        } else {
+          rddata[t].i = rsdata[t][0].i;
+        }
+      }
+    } break;
+    case 1: {
+      // VOTE.ANY, VOTE.ALL, VOTE.BALLOT
+      trace->sfu_type = SfuType::VOTE;
+      ThreadMask ballot;
+      for (uint32_t t = thread_start; t < num_threads; ++t) {
+        ballot[t] = warp.tmask.test(t) && (rsdata[t][0].i != 0);
+      }
+      Word result;
+      switch (func7) {
+      case 0: result = ballot.any(); break;
+      case 1: result = (ballot == warp.tmask); break;
+      case 2: result = ballot.to_ulong(); break;
+      default:
+        std::abort();
+      }
+      for (uint32_t t = thread_start; t < num_threads; ++t) {
+        rddata[t].u = result;
+      }
+    } break;
+    case 2: {
+      // REDUCE.ADD
+      trace->sfu_type = SfuType::REDUCE;
+      if (func7 != 0)
+        std::abort();
+      Word sum = 0;
+      for (uint32_t t = thread_start; t < num_threads; ++t) {
+        if (warp.tmask.test(t)) {
+          sum += rsdata[t][0].u;
+        }
+      }
+      for (uint32_t t = thread_start; t < num_threads; ++t) {
+        rddata[t].u = sum;
+      }
+    } break;
+    default:
+      std::abort();
+    }
+    rd_write = true;
+  } break;
   default:
     std::abort();
   }
@@ -1438,7 +1770,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
             DPN(2, "-");
             continue;
           }
-          warp.ireg_file.at(t)[rdest] = rddata[t].i;
+          warp.ireg_file.at(t, rdest) = rddata[t].i;
           DPN(2, "0x" << std::hex << rddata[t].i);
         }
         DPN(2, "}" << std::endl);
@@ -1457,7 +1789,7 @@ void Emulator::execute(const Instr &instr, uint32_t wid, instr_trace_t *trace) {
           DPN(2, "-");
           continue;
         }
-        warp.freg_file.at(t)[rdest] = rddata[t].u64;
+        warp.freg_file.at(t, rdest) = rddata[t].u64;
         DPN(2, "0x" << std::hex << rddata[t].f);
       }
       DPN(2, "}" << std::endl);
@@ -52,6 +52,7 @@ void AluUnit::tick() {
 		}
 		input.pop();
 	}
+	this->sleep_if_idle();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -87,6 +88,7 @@ void FpuUnit::tick() {
 		DT(3, "pipeline-execute: op=" << trace->fpu_type << ", " << *trace);
 		input.pop();
 	}
+	this->sleep_if_idle();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -94,7 +96,12 @@ void FpuUnit::tick() {
 LsuUnit::LsuUnit(const SimContext& ctx, Core* core)
 	: FuncUnit(ctx, core, "LSU")
 	, pending_loads_(0)
-{}
+{
+	// memory responses are drained directly from the demux ports
+	for (auto& demux : core_->lsu_demux_) {
+		demux->RspIn.listener(this);
+	}
+}
 
 LsuUnit::~LsuUnit()
 {}
@@ -194,6 +201,35 @@ void LsuUnit::tick() {
 		// remove input
 		input.pop();
 	}
+
+	for (auto& input : Inputs) {
+		if (!input.empty())
+			return;
+	}
+	for (auto& state : states_) {
+		if (state.fence_lock && state.pending_rd_reqs.empty())
+			return;
+	}
+
+	// sleep once all outstanding requests have completed,
+	// otherwise only the load latency advances until the next response.
+	if (0 == pending_loads_) {
+		for (auto& state : states_) {
+			if (state.fence_lock)
+				return;
+		}
+		this->sleep();
+	} else {
+		for (auto& demux : core_->lsu_demux_) {
+			if (!demux->RspIn.empty())
+				return;
+		}
+		this->idle();
+	}
+}
+
+void LsuUnit::skip(uint64_t cycles) {
+	core_->perf_stats_.load_latency += pending_loads_ * cycles;
 }
 
 int LsuUnit::send_requests(instr_trace_t* trace, int block_idx, int tag) {
@@ -221,6 +257,7 @@ int LsuUnit::send_requests(instr_trace_t* trace, int block_idx, int tag) {
 		mem_req.tag   = tag;
 		mem_req.cid   = trace->cid;
 		mem_req.uuid  = trace->uuid;
+		mem_req.amo   = trace_data->amo_type;
 
 		dcache_req_port.push(mem_req, 1);
 		DT(3, "mem-req: addr=0x" << std::hex << mem_req.addr << ", tag=" << tag
@@ -272,6 +309,14 @@ void SfuUnit::tick() {
 		case SfuType::CSRRC:
 			output.push(trace, 1);
 			break;
+		case SfuType::SHFL:
+		case SfuType::VOTE:
+			output.push(trace, 2);
+			break;
+		case SfuType::REDUCE:
+			// adder tree across the warp
+			output.push(trace, log2up(core_->arch().num_threads()) + 1);
+			break;
 		case SfuType::BAR: {
 			output.push(trace, 1);
 			if (trace->eop) {
@@ -290,4 +335,5 @@ void SfuUnit::tick() {
 
 		input.pop();
 	}
+	this->sleep_if_idle();
 }
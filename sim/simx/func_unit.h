@@ -16,6 +16,7 @@
 #include <simobject.h>
 #include <array>
 #include "instr_trace.h"
+#include "constants.h"
 
 namespace vortex {
 
@@ -28,7 +29,7 @@ public:
 
 	FuncUnit(const SimContext& ctx, Core* core, const char* name) 
 		: SimObject<FuncUnit>(ctx, name) 
-		, Inputs(ISSUE_WIDTH, this)
+		, Inputs(ISSUE_WIDTH, SimPort<instr_trace_t*>(this, FU_IPORT_SIZE))
 		, Outputs(ISSUE_WIDTH, this)
 		, core_(core)
 	{}
@@ -39,7 +40,18 @@ public:
 
 	virtual void tick() = 0;
 
+	virtual void skip(uint64_t /*cycles*/) {}
+
 protected:
+	// sleep until new instructions arrive
+	void sleep_if_idle() {
+		for (auto& input : Inputs) {
+			if (!input.empty())
+				return;
+		}
+		this->sleep();
+	}
+
 	Core* core_;
 };
 
@@ -70,6 +82,7 @@ public:
 
 	void reset();
 	void tick();
+	void skip(uint64_t cycles);
 
 private:
 
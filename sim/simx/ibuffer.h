@@ -14,14 +14,14 @@
 #pragma once
 
 #include "instr_trace.h"
-#include <queue>
 
 namespace vortex {
 
 class IBuffer {
 public:
 	IBuffer(uint32_t size) 
-		: capacity_(size)
+		: entries_(size)
+		, capacity_(size)
 	{}
 
 	bool empty() const {
@@ -37,20 +37,19 @@ public:
 	}
 
 	void push(instr_trace_t* trace) {
-		entries_.emplace(trace);
+		entries_.push(trace);
 	}
 
 	void pop() {
-		return entries_.pop();
+		entries_.pop();
 	}
 
 	void clear() {
-		std::queue<instr_trace_t*> empty;
-		std::swap(entries_, empty );
+		entries_.clear();
 	}
 
 private:
-	std::queue<instr_trace_t*> entries_;
+	RingQueue<instr_trace_t*> entries_;
 	uint32_t capacity_;
 };
 
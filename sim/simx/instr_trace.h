@@ -16,7 +16,9 @@
 
 #include <memory>
 #include <iostream>
+#include <array>
 #include <util.h>
+#include <mempool.h>
 #include "types.h"
 #include "arch.h"
 #include "debug.h"
@@ -32,8 +34,9 @@ public:
 
 struct LsuTraceData : public ITraceData {
   using Ptr = std::shared_ptr<LsuTraceData>;
-  std::vector<mem_addr_size_t> mem_addrs;
-  LsuTraceData(uint32_t num_threads) : mem_addrs(num_threads) {}
+  std::array<mem_addr_size_t, MAX_NUM_THREADS> mem_addrs;
+  AmoType amo_type;
+  LsuTraceData() : mem_addrs(), amo_type(AmoType::None) {}
 };
 
 struct SFUTraceData : public ITraceData {
@@ -165,4 +168,76 @@ inline std::ostream &operator<<(std::ostream &os, const instr_trace_t& trace) {
   return os;
 }
 
-}
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////
+
+// per-core free lists for the instruction traces and their payloads,
+// sized for the instructions in flight so that the pipeline does not
+// touch the heap once warmed up. Slabs grow on demand past that size.
+class TraceArena {
+public:
+  TraceArena(uint32_t capacity)
+    : traces_(capacity)
+    , data_(capacity)
+  {}
+
+  instr_trace_t* allocate(uint64_t uuid, const Arch& arch) {
+    return new (traces_.allocate()) instr_trace_t(uuid, arch);
+  }
+
+  instr_trace_t* clone(const instr_trace_t& trace) {
+    return new (traces_.allocate()) instr_trace_t(trace);
+  }
+
+  void release(instr_trace_t* trace) {
+    trace->~instr_trace_t();
+    traces_.deallocate(trace);
+  }
+
+  // payloads are shared by the partial traces of an instruction
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make_data(Args&&... args) {
+    return std::allocate_shared<T>(allocator_t<T>(&data_), std::forward<Args>(args)...);
+  }
+
+private:
+  // a payload block holds the largest payload and its reference counts
+  typedef typename std::aligned_storage<sizeof(LsuTraceData) + 64>::type data_block_t;
+
+  template <typename T>
+  struct allocator_t {
+    typedef T value_type;
+
+    allocator_t(MemoryPool<data_block_t>* pool) : pool(pool) {}
+
+    template <typename U>
+    allocator_t(const allocator_t<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+      static_assert(sizeof(T) <= sizeof(data_block_t), "invalid payload size");
+      __unused (n);
+      assert(1 == n);
+      return static_cast<T*>(pool->allocate());
+    }
+
+    void deallocate(T* ptr, size_t) {
+      pool->deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const allocator_t<U>& other) const {
+      return pool == other.pool;
+    }
+
+    template <typename U>
+    bool operator!=(const allocator_t<U>& other) const {
+      return pool != other.pool;
+    }
+
+    MemoryPool<data_block_t>* pool;
+  };
+
+  MemoryPool<instr_trace_t> traces_;
+  MemoryPool<data_block_t> data_;
+};
+
+}
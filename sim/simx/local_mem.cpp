@@ -27,6 +27,7 @@ protected:
 	int32_t   bank_sel_addr_start_;
   int32_t   bank_sel_addr_end_;
 	PerfStats perf_stats_;
+	std::vector<bool> in_used_banks_;
 
 	uint64_t to_local_addr(uint64_t addr) {
 		uint32_t total_lines = config_.capacity / config_.line_size;
@@ -42,6 +43,7 @@ public:
 		, ram_(config.capacity)
 		, bank_sel_addr_start_(0)
 		, bank_sel_addr_end_(config.B-1)
+		, in_used_banks_(1 << config.B)
 	{}
 
 	virtual ~Impl() {}
@@ -63,7 +65,8 @@ public:
 	}
 
 	void tick() {
-		std::vector<bool> in_used_banks(1 << config_.B);
+		auto& in_used_banks = in_used_banks_;
+		std::fill(in_used_banks.begin(), in_used_banks.end(), false);
 		for (uint32_t req_id = 0; req_id < config_.num_reqs; ++req_id) {
 			auto& core_req_port = simobject_->Inputs.at(req_id);
 			if (core_req_port.empty())
@@ -97,6 +100,21 @@ public:
 			// remove input
 			core_req_port.pop();
 		}
+
+		// sleep until new requests arrive
+		for (auto& core_req_port : simobject_->Inputs) {
+			if (!core_req_port.empty())
+				return;
+		}
+		simobject_->sleep();
+	}
+
+	void save(std::ostream& os) const {
+		ram_.save(os);
+	}
+
+	void load(std::istream& is) {
+		ram_.load(is);
 	}
 
 	const PerfStats& perf_stats() const {
@@ -133,6 +151,14 @@ void LocalMem::tick() {
   impl_->tick();
 }
 
+void LocalMem::save(std::ostream& os) const {
+  impl_->save(os);
+}
+
+void LocalMem::load(std::istream& is) {
+  impl_->load(is);
+}
+
 const LocalMem::PerfStats& LocalMem::perf_stats() const {
   return impl_->perf_stats();
 }
\ No newline at end of file
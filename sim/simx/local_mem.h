@@ -61,6 +61,11 @@ public:
 
   void tick();
 
+  // checkpoint the memory contents
+  void save(std::ostream& os) const;
+
+  void load(std::istream& is);
+
   const PerfStats& perf_stats() const;
 
 protected:
@@ -16,7 +16,9 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <chrono>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include "processor.h"
@@ -29,19 +31,26 @@
 using namespace vortex;
 
 static void show_usage() {
-   std::cout << "Usage: [-c <cores>] [-w <warps>] [-t <threads>] [-r: riscv-test] [-s: stats] [-h: help] <program>" << std::endl;
+   std::cout << "Usage: [-c <cores>] [-w <warps>] [-t <threads>] [-j <sim threads>] [-f: functional] [-i <region start instrs>] [-p <region start PC>] [-m: region markers] [-l <region cycles>] [-u <warmup accesses>] [-S <warp scheduler: priority|rr|lrr|gto|twolevel>] [-C <save checkpoint>] [-F: functional-only checkpoint] [-R <restore checkpoint>] [-r: riscv-test] [-s: stats] [-h: help] <program>" << std::endl;
 }
 
 uint32_t num_threads = NUM_THREADS;
 uint32_t num_warps = NUM_WARPS;
 uint32_t num_cores = NUM_CORES;
+uint32_t sim_threads = 1;
+bool functional = false;
+Processor::Region region = {};
+WarpSchedType warp_sched = WarpSchedType::Priority;
+const char* checkpoint = nullptr;
+bool checkpoint_functional = false;
+const char* restore = nullptr;
 bool showStats = false;
 bool riscv_test = false;
 const char* program = nullptr;
 
 static void parse_args(int argc, char **argv) {
   	int c;
-  	while ((c = getopt(argc, argv, "t:w:c:rsh?")) != -1) {
+  	while ((c = getopt(argc, argv, "t:w:c:j:fi:p:ml:u:S:C:FR:rsh?")) != -1) {
     	switch (c) {
       case 't':
         num_threads = atoi(optarg);
@@ -52,6 +61,52 @@ static void parse_args(int argc, char **argv) {
 		  case 'c':
         num_cores = atoi(optarg);
         break;
+      case 'j':
+        sim_threads = atoi(optarg);
+        break;
+      case 'f':
+        functional = true;
+        break;
+      case 'i':
+        region.start_instrs = strtoull(optarg, nullptr, 0);
+        break;
+      case 'p':
+        region.start_pc = strtoull(optarg, nullptr, 0);
+        break;
+      case 'm':
+        region.marker = true;
+        break;
+      case 'l':
+        region.max_cycles = strtoull(optarg, nullptr, 0);
+        break;
+      case 'u':
+        region.warmup = atoi(optarg);
+        break;
+      case 'S':
+        if (!strcmp(optarg, "priority")) {
+          warp_sched = WarpSchedType::Priority;
+        } else if (!strcmp(optarg, "rr")) {
+          warp_sched = WarpSchedType::RoundRobin;
+        } else if (!strcmp(optarg, "lrr")) {
+          warp_sched = WarpSchedType::LooseRoundRobin;
+        } else if (!strcmp(optarg, "gto")) {
+          warp_sched = WarpSchedType::GTO;
+        } else if (!strcmp(optarg, "twolevel")) {
+          warp_sched = WarpSchedType::TwoLevel;
+        } else {
+          std::cout << "Error: invalid warp scheduler: " << optarg << std::endl;
+          exit(-1);
+        }
+        break;
+      case 'C':
+        checkpoint = optarg;
+        break;
+      case 'F':
+        checkpoint_functional = true;
+        break;
+      case 'R':
+        restore = optarg;
+        break;
       case 'r':
         riscv_test = true;
         break;
@@ -69,6 +124,14 @@ static void parse_args(int argc, char **argv) {
     	}
 	}
 
+	if (checkpoint
+   && 0 == region.start_instrs
+   && 0 == region.start_pc
+   && !region.marker) {
+    std::cout << "Error: checkpoints are taken at the start of the detailed region, use -i, -p or -m." << std::endl;
+    exit(-1);
+  }
+
 	if (optind < argc) {
 		program = argv[optind];
     std::cout << "Running " << program << "..." << std::endl;
@@ -96,6 +159,25 @@ int main(int argc, char **argv) {
     // attach memory module
     processor.attach_ram(&ram);
 
+    // tick clusters in parallel
+    processor.set_num_threads(sim_threads);
+
+    // skip the timing model
+    processor.set_functional(functional);
+
+    // detailed region of a hybrid run
+    processor.set_region(region);
+
+    processor.set_warp_scheduler(warp_sched);
+
+    // checkpoint the region start, or resume from it
+    if (checkpoint) {
+      processor.save_checkpoint(checkpoint, checkpoint_functional);
+    }
+    if (restore) {
+      processor.restore_checkpoint(restore);
+    }
+
 	  // setup base DCRs
     const uint64_t startup_addr(STARTUP_ADDR);
     processor.dcr_write(VX_DCR_BASE_STARTUP_ADDR0, startup_addr & 0xffffffff);
@@ -118,7 +200,30 @@ int main(int argc, char **argv) {
     }
 
     // run simulation
+    auto t_start = std::chrono::high_resolution_clock::now();
     exitcode = processor.run();
+    auto t_end = std::chrono::high_resolution_clock::now();
+
+    if (showStats) {
+      double elapsed = std::chrono::duration<double>(t_end - t_start).count();
+      uint64_t cycles = processor.cycles();
+      std::cout << std::fixed << std::setprecision(2);
+      std::cout << "PERF: cycles=" << cycles
+                << ", time=" << (elapsed * 1000) << " ms"
+                << ", cycles/sec=" << (cycles / elapsed) << std::endl;
+      auto region_stats = processor.region_stats();
+      if (region_stats.cycles != 0) {
+        std::cout << "PERF: region: start_cycle=" << region_stats.start_cycle
+                  << ", start_instrs=" << region_stats.start_instrs
+                  << ", cycles=" << region_stats.cycles
+                  << ", instrs=" << region_stats.instrs
+                  << ", IPC=" << (double(region_stats.instrs) / region_stats.cycles)
+                  << ", loads=" << region_stats.loads
+                  << ", stores=" << region_stats.stores
+                  << ", mem_reads=" << region_stats.mem_reads
+                  << ", mem_writes=" << region_stats.mem_writes << std::endl;
+      }
+    }
     if (riscv_test) {
       exitcode = (1 - exitcode);
     }
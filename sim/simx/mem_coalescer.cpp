@@ -12,9 +12,15 @@
 // limitations under the License.
 
 #include "mem_coalescer.h"
+#include "constants.h"
 
 using namespace vortex;
 
+// without near-memory atomics, they are modeled as L1 reads
+inline bool is_cache_amo(const MemReq& req) {
+  return AMO_CACHE_LEVEL != 0 && req.amo != AmoType::None;
+}
+
 MemCoalescer::MemCoalescer(
   const SimContext& ctx, 
   const char* name, 
@@ -80,12 +86,15 @@ void MemCoalescer::tick() {
     std::bitset<64> mask(0);      
     mask.set(i);      
 
-    // coalesce matching requests      
+    // coalesce matching requests, atomics executed by the caches
+    // update memory one lane at a time.
     uint64_t seed_addr = seed.addr & addr_mask;
-    for (uint32_t j = i + 1; j < I; ++j) {
+    for (uint32_t j = i + 1; j < I && !is_cache_amo(seed); ++j) {
       if (sent_mask_.test(j) || ReqIn.at(j).empty())
         continue;
       auto& match = ReqIn.at(j).front();
+      if (is_cache_amo(match))
+        continue;
       uint64_t match_addr = match.addr & addr_mask;
       if (match_addr == seed_addr) {
         mask.set(j);
@@ -112,4 +121,15 @@ void MemCoalescer::tick() {
     last_index_ = 0;
     sent_mask_.reset();
   }
+
+  // sleep until new requests or responses arrive
+  for (auto& req_in : ReqIn) {
+    if (!req_in.empty())
+      return;
+  }
+  for (auto& rsp_out : RspOut) {
+    if (!rsp_out.empty())
+      return;
+  }
+  this->sleep();
 }
\ No newline at end of file
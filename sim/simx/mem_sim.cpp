@@ -14,6 +14,7 @@
 #include "mem_sim.h"
 #include <vector>
 #include <queue>
+#include <mutex>
 #include <stdlib.h>
 
 DISABLE_WARNING_PUSH
@@ -37,6 +38,12 @@ private:
 	PerfStats perf_stats_;
 	ramulator::Gem5Wrapper* dram_;
 
+	// ramulator registers its statistics in a process-wide list
+	static std::mutex& stats_mutex() {
+		static std::mutex s_mutex;
+		return s_mutex;
+	}
+
 public:
 
 	Impl(MemSim* simobject, const Config& config) 
@@ -51,11 +58,13 @@ public:
 		ram_config.add("org", "DDR4_4Gb_x8");
 		ram_config.add("mapping", "defaultmapping");
 		ram_config.set_core_num(config.num_cores);
+		std::lock_guard<std::mutex> lock(stats_mutex());
 		dram_ = new ramulator::Gem5Wrapper(ram_config, MEM_BLOCK_SIZE);
 		Stats::statlist.output("ramulator.ddr4.log");
 	}
 
 	~Impl() {
+		std::lock_guard<std::mutex> lock(stats_mutex());
 		dram_->finish();
 		Stats::statlist.printall();
 		delete dram_;
@@ -79,7 +88,7 @@ public:
 
 	void tick() {
 		if (MEM_CYCLE_RATIO > 0) {
-			auto cycle = SimPlatform::instance().cycles();
+			auto cycle = simobject_->platform().cycles();
 			if ((cycle % MEM_CYCLE_RATIO) == 0)
 				dram_->tick();
 		} else {
@@ -87,8 +96,11 @@ public:
 				dram_->tick();
 		}
 					
-		if (simobject_->MemReqPort.empty())
+		// only the DRAM model is ticking until the next request
+		if (simobject_->MemReqPort.empty()) {
+			simobject_->idle();
 			return;
+		}
 		
 		auto& mem_req = simobject_->MemReqPort.front();
 
@@ -121,7 +133,10 @@ MemSim::MemSim(const SimContext& ctx, const char* name, const Config& config)
 	, MemReqPort(this) 
 	, MemRspPort(this)
 	, impl_(new Impl(this, config))
-{}
+{
+	// the DRAM model advances every cycle
+	this->clocked(true);
+}
 
 MemSim::~MemSim() {
   delete impl_;
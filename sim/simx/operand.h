@@ -14,6 +14,7 @@
 #pragma once
 
 #include "instr_trace.h"
+#include "constants.h"
 
 namespace vortex {
 
@@ -24,8 +25,8 @@ public:
 
     Operand(const SimContext& ctx) 
 			: SimObject<Operand>(ctx, "Operand") 
-			, Input(this)
-			, Output(this)
+			, Input(this, OPERAND_IPORT_SIZE)
+			, Output(this, OPERAND_OPORT_SIZE)
     {}
 
     virtual ~Operand() {}
@@ -33,7 +34,11 @@ public:
     virtual void reset() {}
 
     virtual void tick() {
-			if (Input.empty())
+			if (Input.empty()) {
+				this->sleep();
+				return;
+			}
+			if (Output.full())
 				return;
 			auto trace = Input.front();
 
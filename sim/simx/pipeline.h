@@ -15,7 +15,6 @@
 #pragma once
 
 #include "instr_trace.h"
-#include <queue>
 
 namespace vortex {
 
@@ -41,12 +40,11 @@ public:
   }
 
   void clear() {
-    std::queue<instr_trace_t*> empty;
-    std::swap(queue_, empty);
+    queue_.clear();
   }
 
 protected:
-  std::queue<instr_trace_t*> queue_;
+  RingQueue<instr_trace_t*> queue_;
 };
 
 }
\ No newline at end of file
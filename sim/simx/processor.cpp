@@ -13,23 +13,36 @@
 
 #include "processor.h"
 #include "processor_impl.h"
+#include <fstream>
+#include <string.h>
+#include <serialize.h>
 
 using namespace vortex;
 
+static const char CHECKPOINT_MAGIC[8] = {'V', 'X', 'C', 'K', 'P', 'T', 0, 0};
+static const uint32_t CHECKPOINT_VERSION = 2;
+
 ProcessorImpl::ProcessorImpl(const Arch& arch)
   : arch_(arch)
   , clusters_(arch.num_clusters())
+  , ram_(nullptr)
+  , functional_(false)
+  , region_()
+  , checkpoint_functional_(false)
+  , code_start_(uint64_t(-1))
+  , code_end_(0)
+  , code_epoch_(0)
 {
-  SimPlatform::instance().initialize();
+  platform_.initialize();
 
   // create memory simulator
-  memsim_ = MemSim::Create("dram", MemSim::Config{
+  memsim_ = MemSim::Create(platform_.context(), "dram", MemSim::Config{
     MEMORY_BANKS,
     uint32_t(arch.num_cores()) * arch.num_clusters()
   });
 
   // create L3 cache
-  l3cache_ = CacheSim::Create("l3cache", CacheSim::Config{
+  l3cache_ = CacheSim::Create(platform_.context(), "l3cache", CacheSim::Config{
     !L3_ENABLED,
     log2ceil(L3_CACHE_SIZE),  // C
     log2ceil(MEM_BLOCK_SIZE), // L
@@ -43,6 +56,9 @@ ProcessorImpl::ProcessorImpl(const Arch& arch)
     false,                    // write response
     L3_MSHR_SIZE,             // mshr size
     2,                        // pipeline latency
+    AMO_CACHE_LEVEL ? CacheSim::AmoPolicy::Execute : CacheSim::AmoPolicy::Read, // atomics
+    AMO_LATENCY,              // atomic unit latency
+    AMO_INTERVAL,             // atomic unit interval
     }
   );
 
@@ -50,12 +66,18 @@ ProcessorImpl::ProcessorImpl(const Arch& arch)
   l3cache_->MemReqPort.bind(&memsim_->MemReqPort);
   memsim_->MemRspPort.bind(&l3cache_->MemRspPort);
 
-  // create clusters
+  // create clusters, each cluster is ticked as its own partition
   for (uint32_t i = 0; i < arch.num_clusters(); ++i) {
-    clusters_.at(i) = Cluster::Create(i, this, arch, dcrs_);
+    platform_.new_partition();
+    clusters_.at(i) = Cluster::Create(platform_.context(), i, this, arch, dcrs_);
     // connect L3 core ports
     clusters_.at(i)->mem_req_port.bind(&l3cache_->CoreReqPorts.at(i));
     l3cache_->CoreRspPorts.at(i).bind(&clusters_.at(i)->mem_rsp_port);
+    for (auto& socket : clusters_.at(i)->sockets()) {
+      for (auto& core : socket->cores()) {
+        cores_.push_back(core);
+      }
+    }
   }
 
   // set up memory profiling
@@ -74,23 +96,58 @@ ProcessorImpl::ProcessorImpl(const Arch& arch)
 }
 
 ProcessorImpl::~ProcessorImpl() {
-  SimPlatform::instance().finalize();
+  platform_.finalize();
 }
 
 void ProcessorImpl::attach_ram(RAM* ram) {
+  ram_ = ram;
   for (auto cluster : clusters_) {
     cluster->attach_ram(ram);
   }
 }
 
 int ProcessorImpl::run() {
-  SimPlatform::instance().reset();
+  platform_.reset();
   this->reset();
 
+  // a restored run starts its region at the checkpoint
+  bool restored = !restore_path_.empty();
+  if (restored) {
+    this->read_checkpoint();
+    restore_path_.clear();
+  }
+  if (RegionState::Waiting == region_state_
+   && (restored
+    || (region_.start_instrs == 0
+     && region_.start_pc == 0
+     && !region_.marker))) {
+    this->begin_region();
+  }
+
   bool done;
   int exitcode = 0;
   do {
-    SimPlatform::instance().tick();
+    // hybrid runs only use the timing model inside the region
+    bool timed = (RegionState::None == region_state_) ? !functional_
+               : (RegionState::Active == region_state_
+               || RegionState::Ending == region_state_
+               || RegionState::Draining == region_state_);
+    if (timed) {
+      // skip over cycles where the whole machine is waiting on memory
+      auto skipped = platform_.fast_forward();
+      perf_mem_latency_ += perf_mem_pending_reads_ * skipped;
+      platform_.tick();
+      perf_mem_latency_ += perf_mem_pending_reads_;
+    } else {
+      // one instruction per core and cycle, caches and memory are bypassed
+      for (auto cluster : clusters_) {
+        functional_instrs_ += cluster->step_functional();
+      }
+      ++functional_cycles_;
+    }
+    if (RegionState::None != region_state_) {
+      this->update_region();
+    }
     done = true;
     for (auto cluster : clusters_) {
       if (cluster->running()) {
@@ -99,23 +156,278 @@ int ProcessorImpl::run() {
       }
       exitcode |= cluster->get_exitcode();
     }
-    perf_mem_latency_ += perf_mem_pending_reads_;
   } while (!done);
 
+  // the program ended inside the region
+  if (RegionState::Active == region_state_
+   || RegionState::Ending == region_state_
+   || RegionState::Draining == region_state_) {
+    this->end_region();
+  }
+
   return exitcode;
 }
 
+uint64_t ProcessorImpl::cycles() const {
+  return functional_cycles_ + platform_.cycles();
+}
+
 void ProcessorImpl::reset() {
   perf_mem_reads_ = 0;
   perf_mem_writes_ = 0;
   perf_mem_latency_ = 0;
   perf_mem_pending_reads_ = 0;
+  functional_cycles_ = 0;
+  functional_instrs_ = 0;
+  region_stats_ = Processor::RegionStats();
+  if (region_.start_instrs != 0
+   || region_.start_pc != 0
+   || region_.marker
+   || region_.max_cycles != 0
+   || !restore_path_.empty()) {
+    region_state_ = RegionState::Waiting;
+  } else {
+    region_state_ = RegionState::None;
+  }
 }
 
 void ProcessorImpl::dcr_write(uint32_t addr, uint32_t value) {
   dcrs_.write(addr, value);
 }
 
+void ProcessorImpl::set_num_threads(uint32_t num_threads) {
+  platform_.set_num_threads(num_threads);
+}
+
+void ProcessorImpl::set_functional(bool enable) {
+  functional_ = enable;
+}
+
+void ProcessorImpl::set_region(const Processor::Region& region) {
+  region_ = region;
+  for (auto& core : cores_) {
+    core->set_region(region.start_pc, region.warmup);
+  }
+}
+
+void ProcessorImpl::set_warp_scheduler(WarpSchedType type) {
+  for (auto& core : cores_) {
+    core->set_warp_scheduler(type);
+  }
+}
+
+Processor::RegionStats ProcessorImpl::region_stats() const {
+  return region_stats_;
+}
+
+void ProcessorImpl::code_decoded(uint64_t start, uint64_t end) {
+  auto cur_start = code_start_.load(std::memory_order_relaxed);
+  while (start < cur_start
+      && !code_start_.compare_exchange_weak(cur_start, start, std::memory_order_relaxed));
+  auto cur_end = code_end_.load(std::memory_order_relaxed);
+  while (end > cur_end
+      && !code_end_.compare_exchange_weak(cur_end, end, std::memory_order_relaxed));
+}
+
+void ProcessorImpl::code_written(uint64_t addr, uint64_t size) {
+  if (addr < code_end_.load(std::memory_order_relaxed)
+   && (addr + size) > code_start_.load(std::memory_order_relaxed)) {
+    code_epoch_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void ProcessorImpl::region_trigger() {
+  if (RegionState::Waiting == region_state_) {
+    region_state_ = RegionState::Triggered;
+  }
+}
+
+void ProcessorImpl::region_marker(bool enable) {
+  if (!region_.marker)
+    return;
+  if (enable) {
+    this->region_trigger();
+  } else if (RegionState::Active == region_state_) {
+    region_state_ = RegionState::Ending;
+  }
+}
+
+void ProcessorImpl::warm(uint64_t addr, bool write) {
+  l3cache_->warm(addr, write);
+}
+
+void ProcessorImpl::update_region() {
+  switch (region_state_) {
+  case RegionState::Waiting:
+    if (region_.start_instrs != 0
+     && functional_instrs_ >= region_.start_instrs) {
+      this->begin_region();
+    }
+    break;
+  case RegionState::Triggered:
+    this->begin_region();
+    break;
+  case RegionState::Active:
+    if (region_.max_cycles != 0
+     && platform_.cycles() >= region_.max_cycles) {
+      this->drain_region();
+    }
+    break;
+  case RegionState::Ending:
+    this->drain_region();
+    break;
+  case RegionState::Draining:
+    for (auto& core : cores_) {
+      if (!core->drained())
+        return;
+    }
+    this->end_region();
+    break;
+  default:
+    break;
+  }
+}
+
+void ProcessorImpl::begin_region() {
+  if (region_.warmup != 0) {
+    for (auto& cluster : clusters_) {
+      cluster->warm_caches();
+    }
+  }
+  region_stats_.start_cycle = functional_cycles_;
+  for (auto& core : cores_) {
+    region_stats_.start_instrs += core->perf_stats().instrs;
+  }
+  region_state_ = RegionState::Active;
+
+  if (!checkpoint_path_.empty()) {
+    this->write_checkpoint();
+  }
+}
+
+void ProcessorImpl::drain_region() {
+  // let the issued instructions complete before leaving the timing model
+  for (auto& core : cores_) {
+    core->drain();
+  }
+  region_state_ = RegionState::Draining;
+}
+
+void ProcessorImpl::end_region() {
+  // the timing model only ran in the region, so its counters are the region's
+  region_stats_.cycles      = platform_.cycles();
+  region_stats_.mem_reads   = perf_mem_reads_;
+  region_stats_.mem_writes  = perf_mem_writes_;
+  region_stats_.mem_latency = perf_mem_latency_;
+  for (auto& core : cores_) {
+    auto& core_perf = core->perf_stats();
+    region_stats_.instrs   += core_perf.instrs;
+    region_stats_.ifetches += core_perf.ifetches;
+    region_stats_.loads    += core_perf.loads;
+    region_stats_.stores   += core_perf.stores;
+  }
+  region_stats_.instrs -= region_stats_.start_instrs;
+  region_state_ = RegionState::Done;
+}
+
+void ProcessorImpl::save_checkpoint(const std::string& path, bool functional_only) {
+  checkpoint_path_ = path;
+  checkpoint_functional_ = functional_only;
+}
+
+void ProcessorImpl::restore_checkpoint(const std::string& path) {
+  restore_path_ = path;
+}
+
+void ProcessorImpl::write_checkpoint() {
+  std::ofstream ofs(checkpoint_path_, std::ios::binary);
+  if (!ofs) {
+    std::cout << "Error: cannot create checkpoint " << checkpoint_path_ << std::endl;
+    std::abort();
+  }
+
+  // checkpoints are taken before the timing model runs,
+  // so there are no pending events or in-flight requests to save.
+  assert(0 == platform_.cycles());
+  bool caches = !checkpoint_functional_;
+
+  ofs.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  serialize(ofs, CHECKPOINT_VERSION);
+  serialize(ofs, caches);
+  serialize(ofs, uint32_t(XLEN));
+  serialize(ofs, uint32_t(arch_.num_threads()));
+  serialize(ofs, uint32_t(arch_.num_warps()));
+  serialize(ofs, uint32_t(arch_.num_cores()));
+  serialize(ofs, uint32_t(arch_.num_clusters()));
+  serialize(ofs, functional_cycles_);
+  serialize(ofs, functional_instrs_);
+  dcrs_.save(ofs);
+  ram_->save(ofs);
+  for (auto cluster : clusters_) {
+    cluster->save(ofs, caches);
+  }
+  if (caches) {
+    l3cache_->save(ofs);
+  }
+}
+
+void ProcessorImpl::read_checkpoint() {
+  std::ifstream ifs(restore_path_, std::ios::binary);
+  if (!ifs) {
+    std::cout << "Error: checkpoint " << restore_path_ << " not found" << std::endl;
+    std::abort();
+  }
+
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  uint32_t version = 0;
+  ifs.read(magic, sizeof(magic));
+  deserialize(ifs, version);
+  if (!ifs || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+    std::cout << "Error: invalid checkpoint " << restore_path_ << std::endl;
+    std::abort();
+  }
+  if (version != CHECKPOINT_VERSION) {
+    std::cout << std::dec << "Error: unsupported checkpoint version " << version << std::endl;
+    std::abort();
+  }
+
+  bool caches = false;
+  uint32_t xlen = 0, num_threads = 0, num_warps = 0, num_cores = 0, num_clusters = 0;
+  deserialize(ifs, caches);
+  deserialize(ifs, xlen);
+  deserialize(ifs, num_threads);
+  deserialize(ifs, num_warps);
+  deserialize(ifs, num_cores);
+  deserialize(ifs, num_clusters);
+  if (xlen != XLEN
+   || num_threads != arch_.num_threads()
+   || num_warps != arch_.num_warps()
+   || num_cores != arch_.num_cores()
+   || num_clusters != arch_.num_clusters()) {
+    std::cout << std::dec << "Error: checkpoint configuration mismatch: xlen=" << xlen
+              << ", clusters=" << num_clusters << ", cores=" << num_cores
+              << ", warps=" << num_warps << ", threads=" << num_threads << std::endl;
+    std::abort();
+  }
+
+  // functional-only checkpoints leave the caches cold
+  deserialize(ifs, functional_cycles_);
+  deserialize(ifs, functional_instrs_);
+  dcrs_.load(ifs);
+  ram_->load(ifs);
+  for (auto cluster : clusters_) {
+    cluster->load(ifs, caches);
+  }
+  if (caches) {
+    l3cache_->load(ifs);
+  }
+
+  if (!ifs) {
+    std::cout << "Error: truncated checkpoint " << restore_path_ << std::endl;
+    std::abort();
+  }
+}
+
 ProcessorImpl::PerfStats ProcessorImpl::perf_stats() const {
   ProcessorImpl::PerfStats perf;
   perf.mem_reads   = perf_mem_reads_;
@@ -125,6 +437,22 @@ ProcessorImpl::PerfStats ProcessorImpl::perf_stats() const {
   return perf;
 }
 
+uint64_t ProcessorImpl::perf_amos() const {
+  uint64_t amos = l3cache_->perf_stats().amos;
+  for (auto cluster : clusters_) {
+    amos += cluster->perf_stats().l2cache.amos;
+  }
+  return amos;
+}
+
+uint64_t ProcessorImpl::perf_amo_stalls() const {
+  uint64_t amo_stalls = l3cache_->perf_stats().amo_stalls;
+  for (auto cluster : clusters_) {
+    amo_stalls += cluster->perf_stats().l2cache.amo_stalls;
+  }
+  return amo_stalls;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 Processor::Processor(const Arch& arch)
@@ -143,6 +471,38 @@ int Processor::run() {
   return impl_->run();
 }
 
+uint64_t Processor::cycles() const {
+  return impl_->cycles();
+}
+
 void Processor::dcr_write(uint32_t addr, uint32_t value) {
   return impl_->dcr_write(addr, value);
-}
\ No newline at end of file
+}
+
+void Processor::set_num_threads(uint32_t num_threads) {
+  impl_->set_num_threads(num_threads);
+}
+
+void Processor::set_functional(bool enable) {
+  impl_->set_functional(enable);
+}
+
+void Processor::set_region(const Region& region) {
+  impl_->set_region(region);
+}
+
+void Processor::set_warp_scheduler(WarpSchedType type) {
+  impl_->set_warp_scheduler(type);
+}
+
+Processor::RegionStats Processor::region_stats() const {
+  return impl_->region_stats();
+}
+
+void Processor::save_checkpoint(const std::string& path, bool functional_only) {
+  impl_->save_checkpoint(path, functional_only);
+}
+
+void Processor::restore_checkpoint(const std::string& path) {
+  impl_->restore_checkpoint(path);
+}
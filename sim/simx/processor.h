@@ -14,6 +14,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
+#include "warp_sched.h"
 
 namespace vortex {
 
@@ -23,6 +25,29 @@ class ProcessorImpl;
 
 class Processor {
 public:
+  // hybrid run: execute functionally until a trigger fires, then simulate a
+  // detailed region with the timing model.
+  struct Region {
+    uint64_t start_instrs;  // start after this many instructions, 0 if unused
+    uint64_t start_pc;      // start when a core reaches this PC, 0 if unused
+    bool     marker;        // start/end on kernel writes to VX_CSR_SIM_REGION
+    uint64_t max_cycles;    // region length, 0 for no limit
+    uint32_t warmup;        // recent accesses per core replayed into the caches
+  };
+
+  struct RegionStats {
+    uint64_t start_cycle;
+    uint64_t start_instrs;
+    uint64_t cycles;
+    uint64_t instrs;
+    uint64_t ifetches;
+    uint64_t loads;
+    uint64_t stores;
+    uint64_t mem_reads;
+    uint64_t mem_writes;
+    uint64_t mem_latency;
+  };
+
   Processor(const Arch& arch);
   ~Processor();
 
@@ -30,8 +55,30 @@ public:
 
   int run();
 
+  uint64_t cycles() const;
+
   void dcr_write(uint32_t addr, uint32_t value);
 
+  void set_num_threads(uint32_t num_threads);
+
+  // execute instructions without the timing model
+  void set_functional(bool enable);
+
+  void set_region(const Region& region);
+
+  // warp scheduling policy of the cores' timing model
+  void set_warp_scheduler(WarpSchedType type);
+
+  // counters of the last run's detailed region, zero if it never started
+  RegionStats region_stats() const;
+
+  // write a checkpoint when the detailed region starts,
+  // functional-only checkpoints leave the caches cold.
+  void save_checkpoint(const std::string& path, bool functional_only);
+
+  // resume the next run from a checkpoint, starting its detailed region
+  void restore_checkpoint(const std::string& path);
+
 private:
   ProcessorImpl* impl_;
 };
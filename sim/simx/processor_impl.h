@@ -13,11 +13,13 @@
 
 #pragma once
 
+#include <atomic>
 #include "mem_sim.h"
 #include "cache_sim.h"
 #include "constants.h"
 #include "dcrs.h"
 #include "cluster.h"
+#include "processor.h"
 
 namespace vortex {
 
@@ -37,23 +39,100 @@ public:
 
   int run();
 
+  uint64_t cycles() const;
+
   void dcr_write(uint32_t addr, uint32_t value);
 
+  void set_num_threads(uint32_t num_threads);
+
+  void set_functional(bool enable);
+
+  void set_region(const Processor::Region& region);
+
+  void set_warp_scheduler(WarpSchedType type);
+
+  Processor::RegionStats region_stats() const;
+
+  void save_checkpoint(const std::string& path, bool functional_only);
+
+  void restore_checkpoint(const std::string& path);
+
+  // a core reached the region's start PC
+  void region_trigger();
+
+  // the kernel wrote VX_CSR_SIM_REGION
+  void region_marker(bool enable);
+
+  // miss path of the cluster caches
+  void warm(uint64_t addr, bool write);
+
+  // code range decoded by the cores, a store into it
+  // advances the epoch and the cores flush their decode caches.
+  void code_decoded(uint64_t start, uint64_t end);
+
+  void code_written(uint64_t addr, uint64_t size);
+
+  uint64_t code_epoch() const {
+    return code_epoch_.load(std::memory_order_relaxed);
+  }
+
   PerfStats perf_stats() const;
 
+  // atomics are performed by either the L2s or the L3
+  uint64_t perf_amos() const;
+
+  uint64_t perf_amo_stalls() const;
+
 private:
 
+  enum class RegionState {
+    None,
+    Waiting,
+    Triggered,
+    Active,
+    Ending,
+    Draining,
+    Done
+  };
+
   void reset();
 
+  void update_region();
+
+  void begin_region();
+
+  void drain_region();
+
+  void end_region();
+
+  void write_checkpoint();
+
+  void read_checkpoint();
+
   const Arch& arch_;
+  SimPlatform platform_;
   std::vector<std::shared_ptr<Cluster>> clusters_;
+  std::vector<Core::Ptr> cores_;
   DCRS dcrs_;
+  RAM* ram_;
   MemSim::Ptr memsim_;
   CacheSim::Ptr l3cache_;
   uint64_t perf_mem_reads_;
   uint64_t perf_mem_writes_;
   uint64_t perf_mem_latency_;
   uint64_t perf_mem_pending_reads_;
+  bool functional_;
+  uint64_t functional_cycles_;
+  uint64_t functional_instrs_;
+  Processor::Region region_;
+  RegionState region_state_;
+  Processor::RegionStats region_stats_;
+  std::string checkpoint_path_;
+  bool checkpoint_functional_;
+  std::string restore_path_;
+  std::atomic<uint64_t> code_start_;
+  std::atomic<uint64_t> code_end_;
+  std::atomic<uint64_t> code_epoch_;
 };
 
 }
@@ -14,7 +14,7 @@
 #pragma once
 
 #include "instr_trace.h"
-#include <unordered_map>
+#include <algorithm>
 #include <vector>
 
 namespace vortex {
@@ -33,6 +33,7 @@ public:
 	Scoreboard(const Arch &arch) 
 		: in_use_iregs_(arch.num_warps())
 		, in_use_fregs_(arch.num_warps())
+		, owners_(arch.num_warps() * 2 * MAX_NUM_REGS)
 	{
 		this->clear();
 	}
@@ -42,7 +43,7 @@ public:
 			in_use_iregs_.at(i).reset();
 			in_use_fregs_.at(i).reset();
 		}
-		owners_.clear();
+		std::fill(owners_.begin(), owners_.end(), nullptr);
 	}
 
 	bool in_use(instr_trace_t* trace) const {
@@ -50,29 +51,27 @@ public:
 				|| (trace->used_fregs & in_use_fregs_.at(trace->wid)) != 0;
 	}
 
-	std::vector<reg_use_t> get_uses(instr_trace_t* trace) const {
-		std::vector<reg_use_t> out;
+	// collect the pending writers of the trace's source registers,
+	// 'out' is reused across calls to keep stalls off the heap.
+	void get_uses(instr_trace_t* trace, std::vector<reg_use_t>& out) const {
+		out.clear();
 		
 		auto used_iregs = trace->used_iregs & in_use_iregs_.at(trace->wid);
 		auto used_fregs = trace->used_fregs & in_use_fregs_.at(trace->wid);
 
 		for (uint32_t r = 0; r < MAX_NUM_REGS; ++r) {
 			if (used_iregs.test(r)) {
-				uint32_t tag = (r << 16) | (trace->wid << 4) | (int)RegType::Integer;
-				auto owner = owners_.at(tag);
+				auto owner = owners_.at(owner_index(trace->wid, RegType::Integer, r));
 				out.push_back({RegType::Integer, r, owner->fu_type, owner->sfu_type, owner->uuid});
 			}
 		}
 
 		for (uint32_t r = 0; r < MAX_NUM_REGS; ++r) {
 			if (used_fregs.test(r)) {
-				uint32_t tag = (r << 16) | (trace->wid << 4) | (int)RegType::Float;
-				auto owner = owners_.at(tag);
+				auto owner = owners_.at(owner_index(trace->wid, RegType::Float, r));
 				out.push_back({RegType::Float, r, owner->fu_type, owner->sfu_type, owner->uuid});
 			}
 		}
-
-		return out;
 	}
 	
 	void reserve(instr_trace_t* trace) {
@@ -87,9 +86,9 @@ public:
 		default: 
 			assert(false);
 		}
-		uint32_t tag = (trace->rdest << 16) | (trace->wid << 4) | (int)trace->rdest_type;
-		assert(owners_.count(tag) == 0);
-		owners_[tag] = trace;
+		auto& owner = owners_.at(owner_index(trace->wid, trace->rdest_type, trace->rdest));
+		assert(owner == nullptr);
+		owner = trace;
 		assert((int)trace->fu_type < 5);
 	}
 
@@ -105,15 +104,18 @@ public:
 		default: 
 			assert(false);
 		}
-		uint32_t tag = (trace->rdest << 16) | (trace->wid << 4) | (int)trace->rdest_type;
-		owners_.erase(tag);
+		owners_.at(owner_index(trace->wid, trace->rdest_type, trace->rdest)) = nullptr;
 	}
 
 private:
 
+	static uint32_t owner_index(uint32_t wid, RegType type, uint32_t reg) {
+		return (wid * 2 + (type == RegType::Float)) * MAX_NUM_REGS + reg;
+	}
+
 	std::vector<RegMask> in_use_iregs_;
 	std::vector<RegMask> in_use_fregs_;
-	std::unordered_map<uint32_t, instr_trace_t*> owners_;
+	std::vector<instr_trace_t*> owners_;
 };
 
 }
\ No newline at end of file
@@ -34,7 +34,7 @@ Socket::Socket(const SimContext& ctx,
 
   char sname[100];
   snprintf(sname, 100, "socket%d-icaches", socket_id);
-  icaches_ = CacheCluster::Create(sname, cores_per_socket, NUM_ICACHES, 1, CacheSim::Config{
+  icaches_ = CacheCluster::Create(ctx, sname, cores_per_socket, NUM_ICACHES, 1, CacheSim::Config{
     !ICACHE_ENABLED,
     log2ceil(ICACHE_SIZE),  // C
     log2ceil(L1_LINE_SIZE), // L
@@ -48,13 +48,16 @@ Socket::Socket(const SimContext& ctx,
     false,                  // write response
     (uint8_t)arch.num_warps(), // mshr size
     2,                      // pipeline latency
+    CacheSim::AmoPolicy::Read, // atomics
+    AMO_LATENCY,            // atomic unit latency
+    AMO_INTERVAL,           // atomic unit interval
   });
 
   icaches_->MemReqPort.bind(&icache_mem_req_port);
   icache_mem_rsp_port.bind(&icaches_->MemRspPort);
 
   snprintf(sname, 100, "socket%d-dcaches", socket_id);
-  dcaches_ = CacheCluster::Create(sname, cores_per_socket, NUM_DCACHES, DCACHE_NUM_REQS, CacheSim::Config{
+  dcaches_ = CacheCluster::Create(ctx, sname, cores_per_socket, NUM_DCACHES, DCACHE_NUM_REQS, CacheSim::Config{
     !DCACHE_ENABLED,
     log2ceil(DCACHE_SIZE),  // C
     log2ceil(L1_LINE_SIZE), // L
@@ -68,6 +71,9 @@ Socket::Socket(const SimContext& ctx,
     false,                  // write response
     DCACHE_MSHR_SIZE,       // mshr size
     2,                      // pipeline latency
+    AMO_CACHE_LEVEL ? CacheSim::AmoPolicy::Forward : CacheSim::AmoPolicy::Read, // atomics
+    AMO_LATENCY,            // atomic unit latency
+    AMO_INTERVAL,           // atomic unit interval
   });
 
   dcaches_->MemReqPort.bind(&dcache_mem_req_port);
@@ -77,7 +83,7 @@ Socket::Socket(const SimContext& ctx,
 
   for (uint32_t i = 0; i < cores_per_socket; ++i) {
     uint32_t core_id = socket_id * cores_per_socket + i;
-    cores_.at(i) = Core::Create(core_id, this, arch, dcrs);
+    cores_.at(i) = Core::Create(ctx, core_id, this, arch, dcrs);
 
     cores_.at(i)->icache_req_ports.at(0).bind(&icaches_->CoreReqPorts.at(i).at(0));
     icaches_->CoreRspPorts.at(i).at(0).bind(&cores_.at(i)->icache_rsp_ports.at(0));
@@ -98,7 +104,7 @@ void Socket::reset() {
 }
 
 void Socket::tick() {
-  //--
+  this->sleep();
 }
 
 void Socket::attach_ram(RAM* ram) {
@@ -115,6 +121,59 @@ bool Socket::running() const {
   return false;
 }
 
+uint32_t Socket::step_functional() {
+  uint32_t num_instrs = 0;
+  for (auto& core : cores_) {
+    num_instrs += core->step_functional();
+  }
+  return num_instrs;
+}
+
+void Socket::warm_caches() {
+  std::vector<std::vector<Emulator::mem_access_t>> windows;
+  size_t max_size = 0;
+  for (auto& core : cores_) {
+    windows.push_back(core->access_window());
+    max_size = std::max(max_size, windows.back().size());
+  }
+
+  // replay the cores' accesses in turns with the most recent ones aligned,
+  // what goes through the L1 continues to the cluster.
+  for (size_t i = 0; i < max_size; ++i) {
+    for (uint32_t c = 0, n = cores_.size(); c < n; ++c) {
+      auto& window = windows.at(c);
+      size_t offset = max_size - window.size();
+      if (i < offset)
+        continue;
+      auto& access = window.at(i - offset);
+      auto& caches = access.ifetch ? icaches_ : dcaches_;
+      if (caches->warm(c, access.addr, access.write)) {
+        cluster_->warm(access.addr, access.write);
+      }
+    }
+  }
+}
+
+void Socket::save(std::ostream& os, bool caches) const {
+  for (auto& core : cores_) {
+    core->save(os);
+  }
+  if (caches) {
+    icaches_->save(os);
+    dcaches_->save(os);
+  }
+}
+
+void Socket::load(std::istream& is, bool caches) {
+  for (auto& core : cores_) {
+    core->load(is);
+  }
+  if (caches) {
+    icaches_->load(is);
+    dcaches_->load(is);
+  }
+}
+
 int Socket::get_exitcode() const {
   int exitcode = 0;
   for (auto& core : cores_) {
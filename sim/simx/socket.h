@@ -54,6 +54,10 @@ public:
     return cluster_;
   }
 
+  const std::vector<Core::Ptr>& cores() const {
+    return cores_;
+  }
+
   void reset();
 
   void tick();
@@ -62,6 +66,14 @@ public:
 
   bool running() const;
 
+  uint32_t step_functional();
+
+  void warm_caches();
+
+  void save(std::ostream& os, bool caches) const;
+
+  void load(std::istream& is, bool caches);
+
   int get_exitcode() const;  
 
   void barrier(uint32_t bar_id, uint32_t count, uint32_t core_id);
@@ -0,0 +1,748 @@
+// Copyright © 2019-2023
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <stdlib.h>
+#include <assert.h>
+#include <util.h>
+#include "emulator.h"
+#include "instr.h"
+#include "instr_trace.h"
+#include "dcrs.h"
+#include "core.h"
+
+using namespace vortex;
+
+// Each decoded instruction keeps a pointer to a handler specialized for its
+// operation, with its operands resolved at decode time. The handlers produce
+// the same trace as execute(), without its per-instruction operand vectors.
+//
+// Lanes are processed in fixed-size blocks over the register-major register
+// file, the compiler turns the block loops into SIMD code. Inactive lanes are
+// computed too and discarded by the writeback blend, so the ALU operations
+// must not have side effects.
+
+namespace {
+
+static const uint32_t LANE_BLOCK = 4;
+
+// per-lane select masks of a block, indexed by its thread mask bits
+struct LaneMasks {
+  Word masks[1 << LANE_BLOCK][LANE_BLOCK];
+  LaneMasks() {
+    for (uint32_t i = 0; i < (1 << LANE_BLOCK); ++i) {
+      for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+        masks[i][j] = ((i >> j) & 0x1) ? ~Word(0) : Word(0);
+      }
+    }
+  }
+};
+
+static const LaneMasks sc_lane_masks;
+
+inline const Word* lane_masks(uint64_t tmask, uint32_t t) {
+  return sc_lane_masks.masks[(tmask >> t) & ((1 << LANE_BLOCK) - 1)];
+}
+
+struct AluAdd {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a + b; }
+};
+
+struct AluSub {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a - b; }
+};
+
+struct AluSll {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a << (b & (XLEN-1)); }
+};
+
+struct AluSlt {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return WordI(a) < WordI(b); }
+};
+
+struct AluSltu {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a < b; }
+};
+
+struct AluXor {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a ^ b; }
+};
+
+struct AluSrl {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a >> (b & (XLEN-1)); }
+};
+
+struct AluSra {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return WordI(a) >> (b & (XLEN-1)); }
+};
+
+struct AluOr {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a | b; }
+};
+
+struct AluAnd {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a & b; }
+};
+
+struct AluMul {
+  static AluType type() { return AluType::IMUL; }
+  static Word eval(Word a, Word b) { return a * b; }
+};
+
+struct AluMulh {
+  static AluType type() { return AluType::IMUL; }
+  static Word eval(Word a, Word b) { return (DWordI(WordI(a)) * DWordI(WordI(b))) >> XLEN; }
+};
+
+struct AluMulhsu {
+  static AluType type() { return AluType::IMUL; }
+  static Word eval(Word a, Word b) { return (DWord(DWordI(WordI(a))) * DWord(b)) >> XLEN; }
+};
+
+struct AluMulhu {
+  static AluType type() { return AluType::IMUL; }
+  static Word eval(Word a, Word b) { return (DWord(a) * DWord(b)) >> XLEN; }
+};
+
+struct AluDiv {
+  static AluType type() { return AluType::IDIV; }
+  static Word eval(Word a, Word b) {
+    auto largest_negative = WordI(1) << (XLEN-1);
+    if (b == 0)
+      return Word(-1);
+    if (WordI(a) == largest_negative && WordI(b) == -1)
+      return a;
+    return WordI(a) / WordI(b);
+  }
+};
+
+struct AluDivu {
+  static AluType type() { return AluType::IDIV; }
+  static Word eval(Word a, Word b) {
+    if (b == 0)
+      return Word(-1);
+    return a / b;
+  }
+};
+
+struct AluRem {
+  static AluType type() { return AluType::IDIV; }
+  static Word eval(Word a, Word b) {
+    auto largest_negative = WordI(1) << (XLEN-1);
+    if (b == 0)
+      return a;
+    if (WordI(a) == largest_negative && WordI(b) == -1)
+      return 0;
+    return WordI(a) % WordI(b);
+  }
+};
+
+struct AluRemu {
+  static AluType type() { return AluType::IDIV; }
+  static Word eval(Word a, Word b) {
+    if (b == 0)
+      return a;
+    return a % b;
+  }
+};
+
+struct AluAndn {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a & ~b; }
+};
+
+struct AluOrn {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a | ~b; }
+};
+
+struct AluXnor {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return ~(a ^ b); }
+};
+
+struct AluMin {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (WordI(a) < WordI(b)) ? a : b; }
+};
+
+struct AluMinu {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (a < b) ? a : b; }
+};
+
+struct AluMax {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (WordI(a) < WordI(b)) ? b : a; }
+};
+
+struct AluMaxu {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (a < b) ? b : a; }
+};
+
+template <uint32_t N>
+struct AluShAdd {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (a << N) + b; }
+};
+
+struct AluRol {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return rotate_left(a, b); }
+};
+
+struct AluRor {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return rotate_right(a, b); }
+};
+
+struct AluBset {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a | (Word(1) << (b & (XLEN-1))); }
+};
+
+struct AluBclr {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a & ~(Word(1) << (b & (XLEN-1))); }
+};
+
+struct AluBinv {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return a ^ (Word(1) << (b & (XLEN-1))); }
+};
+
+struct AluBext {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word b) { return (a >> (b & (XLEN-1))) & 0x1; }
+};
+
+// unary operations, the second operand holds the encoding
+struct AluClz {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return count_leading_zeros(a); }
+};
+
+struct AluCtz {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return count_trailing_zeros(a); }
+};
+
+struct AluCpop {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return count_ones(a); }
+};
+
+struct AluSextb {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return WordI(int8_t(a)); }
+};
+
+struct AluSexth {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return WordI(int16_t(a)); }
+};
+
+struct AluZexth {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return a & 0xffff; }
+};
+
+struct AluOrcb {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return or_combine_bytes(a); }
+};
+
+struct AluRev8 {
+  static AluType type() { return AluType::ARITH; }
+  static Word eval(Word a, Word) { return byte_swap(a); }
+};
+
+struct BrEq {
+  static bool eval(Word a, Word b) { return a == b; }
+};
+
+struct BrNe {
+  static bool eval(Word a, Word b) { return a != b; }
+};
+
+struct BrLt {
+  static bool eval(Word a, Word b) { return WordI(a) < WordI(b); }
+};
+
+struct BrGe {
+  static bool eval(Word a, Word b) { return WordI(a) >= WordI(b); }
+};
+
+struct BrLtu {
+  static bool eval(Word a, Word b) { return a < b; }
+};
+
+struct BrGeu {
+  static bool eval(Word a, Word b) { return a >= b; }
+};
+
+// identity CSRs, their value only depends on the thread's position
+struct CsrThreadId {
+  static Word eval(const Arch&, uint32_t, uint32_t, uint32_t tid) { return tid; }
+};
+
+struct CsrWarpId {
+  static Word eval(const Arch&, uint32_t, uint32_t wid, uint32_t) { return wid; }
+};
+
+struct CsrCoreId {
+  static Word eval(const Arch&, uint32_t cid, uint32_t, uint32_t) { return cid; }
+};
+
+struct CsrHartId {
+  static Word eval(const Arch& arch, uint32_t cid, uint32_t wid, uint32_t tid) {
+    return (cid * arch.num_warps() + wid) * arch.num_threads() + tid;
+  }
+};
+
+struct CsrNumThreads {
+  static Word eval(const Arch& arch, uint32_t, uint32_t, uint32_t) { return arch.num_threads(); }
+};
+
+struct CsrNumWarps {
+  static Word eval(const Arch& arch, uint32_t, uint32_t, uint32_t) { return arch.num_warps(); }
+};
+
+struct CsrNumCores {
+  static Word eval(const Arch& arch, uint32_t, uint32_t, uint32_t) { return uint32_t(arch.num_cores()) * arch.num_clusters(); }
+};
+
+struct CsrNumBarriers {
+  static Word eval(const Arch& arch, uint32_t, uint32_t, uint32_t) { return arch.num_barriers(); }
+};
+
+}
+
+Emulator::uop_handler_t Emulator::translate(const Instr &instr) const {
+  auto func3 = instr.getFunc3();
+  auto func7 = instr.getFunc7();
+  switch (instr.getOpcode()) {
+  case Opcode::LUI:
+    return &Emulator::uop_upper<false>;
+  case Opcode::AUIPC:
+    return &Emulator::uop_upper<true>;
+  case Opcode::R:
+    if (func7 == 0x1) {
+      switch (func3) {
+      case 0: return &Emulator::uop_alu<AluMul, false>;
+      case 1: return &Emulator::uop_alu<AluMulh, false>;
+      case 2: return &Emulator::uop_alu<AluMulhsu, false>;
+      case 3: return &Emulator::uop_alu<AluMulhu, false>;
+      case 4: return &Emulator::uop_alu<AluDiv, false>;
+      case 5: return &Emulator::uop_alu<AluDivu, false>;
+      case 6: return &Emulator::uop_alu<AluRem, false>;
+      case 7: return &Emulator::uop_alu<AluRemu, false>;
+      }
+    } else if (func7 == 0x20) {
+      switch (func3) {
+      case 0: return &Emulator::uop_alu<AluSub, false>;
+      case 4: return &Emulator::uop_alu<AluXnor, false>;
+      case 5: return &Emulator::uop_alu<AluSra, false>;
+      case 6: return &Emulator::uop_alu<AluOrn, false>;
+      case 7: return &Emulator::uop_alu<AluAndn, false>;
+      }
+    } else if (func7 == 0x05) {
+      switch (func3) {
+      case 4: return &Emulator::uop_alu<AluMin, false>;
+      case 5: return &Emulator::uop_alu<AluMinu, false>;
+      case 6: return &Emulator::uop_alu<AluMax, false>;
+      case 7: return &Emulator::uop_alu<AluMaxu, false>;
+      }
+    } else if (func7 == 0x10) {
+      switch (func3) {
+      case 2: return &Emulator::uop_alu<AluShAdd<1>, false>;
+      case 4: return &Emulator::uop_alu<AluShAdd<2>, false>;
+      case 6: return &Emulator::uop_alu<AluShAdd<3>, false>;
+      }
+    } else if (func7 == 0x04) {
+      if (func3 == 4)
+        return &Emulator::uop_alu<AluZexth, false>;
+    } else if (func7 == 0x14) {
+      if (func3 == 1)
+        return &Emulator::uop_alu<AluBset, false>;
+    } else if (func7 == 0x24) {
+      switch (func3) {
+      case 1: return &Emulator::uop_alu<AluBclr, false>;
+      case 5: return &Emulator::uop_alu<AluBext, false>;
+      }
+    } else if (func7 == 0x30) {
+      switch (func3) {
+      case 1: return &Emulator::uop_alu<AluRol, false>;
+      case 5: return &Emulator::uop_alu<AluRor, false>;
+      }
+    } else if (func7 == 0x34) {
+      if (func3 == 1)
+        return &Emulator::uop_alu<AluBinv, false>;
+    } else if (func7 == 0) {
+      switch (func3) {
+      case 0: return &Emulator::uop_alu<AluAdd, false>;
+      case 1: return &Emulator::uop_alu<AluSll, false>;
+      case 2: return &Emulator::uop_alu<AluSlt, false>;
+      case 3: return &Emulator::uop_alu<AluSltu, false>;
+      case 4: return &Emulator::uop_alu<AluXor, false>;
+      case 5: return &Emulator::uop_alu<AluSrl, false>;
+      case 6: return &Emulator::uop_alu<AluOr, false>;
+      case 7: return &Emulator::uop_alu<AluAnd, false>;
+      }
+    }
+    break;
+  case Opcode::I:
+    switch (func3) {
+    case 0: return &Emulator::uop_alu<AluAdd, true>;
+    case 2: return &Emulator::uop_alu<AluSlt, true>;
+    case 3: return &Emulator::uop_alu<AluSltu, true>;
+    case 4: return &Emulator::uop_alu<AluXor, true>;
+    case 6: return &Emulator::uop_alu<AluOr, true>;
+    case 7: return &Emulator::uop_alu<AluAnd, true>;
+    case 1:
+      // the low bit of func7 holds the RV64 shift amount
+      switch (func7 & ~0x1) {
+      case 0x00: return &Emulator::uop_alu<AluSll, true>;
+      case 0x14: return &Emulator::uop_alu<AluBset, true>;
+      case 0x24: return &Emulator::uop_alu<AluBclr, true>;
+      case 0x34: return &Emulator::uop_alu<AluBinv, true>;
+      case 0x30:
+        switch (instr.getImm()) {
+        case 0: return &Emulator::uop_alu<AluClz, true>;
+        case 1: return &Emulator::uop_alu<AluCtz, true>;
+        case 2: return &Emulator::uop_alu<AluCpop, true>;
+        case 4: return &Emulator::uop_alu<AluSextb, true>;
+        case 5: return &Emulator::uop_alu<AluSexth, true>;
+        }
+        break;
+      }
+      break;
+    case 5:
+      switch (func7 & ~0x1) {
+      case 0x00: return &Emulator::uop_alu<AluSrl, true>;
+      case 0x20: return &Emulator::uop_alu<AluSra, true>;
+      case 0x24: return &Emulator::uop_alu<AluBext, true>;
+      case 0x30: return &Emulator::uop_alu<AluRor, true>;
+      case 0x14:
+        if (instr.getImm() == 0x7)
+          return &Emulator::uop_alu<AluOrcb, true>;
+        break;
+      case 0x34:
+        if (instr.getImm() == (XLEN - 8))
+          return &Emulator::uop_alu<AluRev8, true>;
+        break;
+      }
+      break;
+    }
+    break;
+  case Opcode::B:
+    switch (func3) {
+    case 0: return &Emulator::uop_branch<BrEq>;
+    case 1: return &Emulator::uop_branch<BrNe>;
+    case 4: return &Emulator::uop_branch<BrLt>;
+    case 5: return &Emulator::uop_branch<BrGe>;
+    case 6: return &Emulator::uop_branch<BrLtu>;
+    case 7: return &Emulator::uop_branch<BrGeu>;
+    }
+    break;
+  case Opcode::JAL:
+    return &Emulator::uop_jal;
+  case Opcode::JALR:
+    return &Emulator::uop_jalr;
+  case Opcode::L:
+    switch (func3) {
+    case 0: return &Emulator::uop_load<int8_t>;
+    case 1: return &Emulator::uop_load<int16_t>;
+    case 2: return &Emulator::uop_load<int32_t>;
+    case 4: return &Emulator::uop_load<uint8_t>;
+    case 5: return &Emulator::uop_load<uint16_t>;
+  #if (XLEN == 64)
+    case 3: return &Emulator::uop_load<int64_t>;
+    case 6: return &Emulator::uop_load<uint32_t>;
+  #endif
+    }
+    break;
+  case Opcode::S:
+    switch (func3) {
+    case 0: return &Emulator::uop_store<uint8_t>;
+    case 1: return &Emulator::uop_store<uint16_t>;
+    case 2: return &Emulator::uop_store<uint32_t>;
+  #if (XLEN == 64)
+    case 3: return &Emulator::uop_store<uint64_t>;
+  #endif
+    }
+    break;
+  case Opcode::SYS:
+    // CSRR of the identity CSRs
+    if (func3 == 2 && instr.getRSrc(0) == 0) {
+      switch (instr.getImm()) {
+      case VX_CSR_THREAD_ID:   return &Emulator::uop_csr_id<CsrThreadId>;
+      case VX_CSR_WARP_ID:     return &Emulator::uop_csr_id<CsrWarpId>;
+      case VX_CSR_CORE_ID:     return &Emulator::uop_csr_id<CsrCoreId>;
+      case VX_CSR_MHARTID:     return &Emulator::uop_csr_id<CsrHartId>;
+      case VX_CSR_NUM_THREADS: return &Emulator::uop_csr_id<CsrNumThreads>;
+      case VX_CSR_NUM_WARPS:   return &Emulator::uop_csr_id<CsrNumWarps>;
+      case VX_CSR_NUM_CORES:   return &Emulator::uop_csr_id<CsrNumCores>;
+      case VX_CSR_NUM_BARRIERS:return &Emulator::uop_csr_id<CsrNumBarriers>;
+      }
+    }
+    break;
+  default:
+    break;
+  }
+  return nullptr;
+}
+
+void Emulator::uop_trace(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  trace->cid   = core_->id();
+  trace->wid   = wid;
+  trace->PC    = warp.PC;
+  trace->tmask = warp.tmask;
+  trace->rdest = uop.rd;
+  trace->rdest_type = uop.instr->getRDType();
+}
+
+template <typename Op, bool Imm>
+void Emulator::uop_alu(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::ALU;
+  trace->alu_type = Op::type();
+  trace->used_iregs.set(uop.rs1);
+  if (!Imm) {
+    trace->used_iregs.set(uop.rs2);
+  }
+  if (uop.rd != 0) {
+    auto rd  = warp.ireg_file.lanes(uop.rd);
+    auto rs1 = warp.ireg_file.lanes(uop.rs1);
+    auto rs2 = warp.ireg_file.lanes(uop.rs2);
+    auto tmask = warp.tmask.to_ullong();
+    for (uint32_t t = 0, n = warp.ireg_file.stride(); t < n; t += LANE_BLOCK) {
+      auto mask = lane_masks(tmask, t);
+      auto a = rs1 + t;
+      auto b = rs2 + t;
+      auto d = rd + t;
+      Word result[LANE_BLOCK];
+      for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+        result[j] = Op::eval(a[j], Imm ? uop.imm : b[j]);
+      }
+      for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+        result[j] = (result[j] & mask[j]) | (d[j] & ~mask[j]);
+      }
+      for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+        d[j] = result[j];
+      }
+    }
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  warp.PC += 4;
+}
+
+template <bool PCRel>
+void Emulator::uop_upper(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::ALU;
+  trace->alu_type = AluType::ARITH;
+  if (uop.rd != 0) {
+    Word value = PCRel ? (uop.imm + warp.PC) : uop.imm;
+    this->uop_write(uop.rd, value, warp);
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  warp.PC += 4;
+}
+
+template <typename Cmp>
+void Emulator::uop_branch(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::ALU;
+  trace->alu_type = AluType::BRANCH;
+  trace->used_iregs.set(uop.rs1);
+  trace->used_iregs.set(uop.rs2);
+  auto rs1 = warp.ireg_file.lanes(uop.rs1);
+  auto rs2 = warp.ireg_file.lanes(uop.rs2);
+  uint64_t taken = 0;
+  for (uint32_t t = 0, n = warp.ireg_file.stride(); t < n; t += LANE_BLOCK) {
+    auto a = rs1 + t;
+    auto b = rs2 + t;
+    uint64_t block = 0;
+    for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+      block |= uint64_t(Cmp::eval(a[j], b[j])) << j;
+    }
+    taken |= block << t;
+  }
+  auto tmask = warp.tmask.to_ullong();
+  taken &= tmask;
+  if (taken != 0 && taken != tmask) {
+    std::cout << "divergent branch! PC=0x" << std::hex << warp.PC << " (#" << std::dec << trace->uuid << ")\n" << std::flush;
+    std::abort();
+  }
+  trace->fetch_stall = true;
+  warp.PC += taken ? uop.imm : 4;
+}
+
+void Emulator::uop_jal(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::ALU;
+  trace->alu_type = AluType::BRANCH;
+  if (uop.rd != 0) {
+    this->uop_write(uop.rd, warp.PC + 4, warp);
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  trace->fetch_stall = true;
+  warp.PC += uop.imm;
+}
+
+void Emulator::uop_jalr(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::ALU;
+  trace->alu_type = AluType::BRANCH;
+  trace->used_iregs.set(uop.rs1);
+  // the target comes from the last active thread, read before rd is written
+  uint32_t thread_last = arch_.num_threads() - 1;
+  while (!warp.tmask.test(thread_last)) {
+    --thread_last;
+  }
+  Word next_pc = warp.ireg_file.at(thread_last, uop.rs1) + uop.imm;
+  if (uop.rd != 0) {
+    this->uop_write(uop.rd, warp.PC + 4, warp);
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  trace->fetch_stall = true;
+  warp.PC = next_pc;
+}
+
+void Emulator::uop_write(uint32_t reg, Word value, warp_t& warp) {
+  auto rd = warp.ireg_file.lanes(reg);
+  auto tmask = warp.tmask.to_ullong();
+  for (uint32_t t = 0, n = warp.ireg_file.stride(); t < n; t += LANE_BLOCK) {
+    auto mask = lane_masks(tmask, t);
+    auto d = rd + t;
+    Word result[LANE_BLOCK];
+    for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+      result[j] = (value & mask[j]) | (d[j] & ~mask[j]);
+    }
+    for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+      d[j] = result[j];
+    }
+  }
+}
+
+void Emulator::uop_addrs(const decode_entry_t& uop, warp_t& warp, Word* addrs) {
+  auto rs1 = warp.ireg_file.lanes(uop.rs1);
+  for (uint32_t t = 0, n = warp.ireg_file.stride(); t < n; t += LANE_BLOCK) {
+    auto a = rs1 + t;
+    auto d = addrs + t;
+    for (uint32_t j = 0; j < LANE_BLOCK; ++j) {
+      d[j] = a[j] + uop.imm;
+    }
+  }
+}
+
+template <typename T>
+void Emulator::uop_load(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::LSU;
+  trace->lsu_type = LsuType::LOAD;
+  trace->used_iregs.set(uop.rs1);
+  auto num_threads = arch_.num_threads();
+  auto trace_data = core_->trace_arena().make_data<LsuTraceData>();
+  trace->data = trace_data;
+  Word addrs[MAX_NUM_THREADS];
+  this->uop_addrs(uop, warp, addrs);
+  auto rd = warp.ireg_file.lanes(uop.rd);
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    if (!warp.tmask.test(t))
+      continue;
+    uint64_t mem_addr = addrs[t];
+    uint64_t read_data = 0;
+    this->dcache_read(&read_data, mem_addr, sizeof(T));
+    trace_data->mem_addrs.at(t) = {mem_addr, uint32_t(sizeof(T))};
+    if (uop.rd != 0) {
+      rd[t] = Word(T(read_data));
+    }
+  }
+  if (uop.rd != 0) {
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  warp.PC += 4;
+}
+
+template <typename T>
+void Emulator::uop_store(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::LSU;
+  trace->lsu_type = LsuType::STORE;
+  trace->used_iregs.set(uop.rs1);
+  trace->used_iregs.set(uop.rs2);
+  auto num_threads = arch_.num_threads();
+  auto trace_data = core_->trace_arena().make_data<LsuTraceData>();
+  trace->data = trace_data;
+  Word addrs[MAX_NUM_THREADS];
+  this->uop_addrs(uop, warp, addrs);
+  auto rs2 = warp.ireg_file.lanes(uop.rs2);
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    if (!warp.tmask.test(t))
+      continue;
+    uint64_t mem_addr = addrs[t];
+    uint64_t write_data = rs2[t];
+    trace_data->mem_addrs.at(t) = {mem_addr, uint32_t(sizeof(T))};
+    this->dcache_write(&write_data, mem_addr, sizeof(T));
+  }
+  warp.PC += 4;
+}
+
+template <typename Csr>
+void Emulator::uop_csr_id(const decode_entry_t& uop, uint32_t wid, instr_trace_t* trace) {
+  auto& warp = warps_.at(wid);
+  this->uop_trace(uop, wid, trace);
+  trace->fu_type = FUType::SFU;
+  trace->sfu_type = SfuType::CSRRS;
+  trace->fetch_stall = true;
+  trace->used_iregs.set(uop.rs1);
+  if (uop.rd != 0) {
+    auto rd = warp.ireg_file.lanes(uop.rd);
+    auto cid = core_->id();
+    auto num_threads = arch_.num_threads();
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      if (warp.tmask.test(t)) {
+        rd[t] = Csr::eval(arch_, cid, wid, t);
+      }
+    }
+    trace->used_iregs.set(uop.rd);
+    trace->wb = true;
+  }
+  warp.PC += 4;
+}
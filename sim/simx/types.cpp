@@ -56,5 +56,10 @@ void LocalMemDemux::tick() {
       ReqDC.push(req, delay_);
     }
     ReqIn.pop();
-  }   
+  }
+
+  // sleep until new requests or responses arrive
+  if (ReqIn.empty() && RspSM.empty() && RspDC.empty()) {
+    this->sleep();
+  }
 }
\ No newline at end of file
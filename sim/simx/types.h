@@ -165,6 +165,42 @@ inline std::ostream &operator<<(std::ostream &os, const AddrType& type) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+enum class AmoType {
+  None,
+  LR,
+  SC,
+  ADD,
+  SWAP,
+  XOR,
+  OR,
+  AND,
+  MIN,
+  MAX,
+  MINU,
+  MAXU
+};
+
+inline std::ostream &operator<<(std::ostream &os, const AmoType& type) {
+  switch (type) {
+  case AmoType::None: os << "None"; break;
+  case AmoType::LR:   os << "LR"; break;
+  case AmoType::SC:   os << "SC"; break;
+  case AmoType::ADD:  os << "ADD"; break;
+  case AmoType::SWAP: os << "SWAP"; break;
+  case AmoType::XOR:  os << "XOR"; break;
+  case AmoType::OR:   os << "OR"; break;
+  case AmoType::AND:  os << "AND"; break;
+  case AmoType::MIN:  os << "MIN"; break;
+  case AmoType::MAX:  os << "MAX"; break;
+  case AmoType::MINU: os << "MINU"; break;
+  case AmoType::MAXU: os << "MAXU"; break;
+  default: assert(false);
+  }
+  return os;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 struct mem_addr_size_t {
   uint64_t addr;
   uint32_t size;
@@ -203,7 +239,10 @@ enum class SfuType {
   PRED,
   CSRRW,
   CSRRS,
-  CSRRC
+  CSRRC,
+  SHFL,
+  VOTE,
+  REDUCE
 };
 
 inline std::ostream &operator<<(std::ostream &os, const SfuType& type) {
@@ -217,6 +256,9 @@ inline std::ostream &operator<<(std::ostream &os, const SfuType& type) {
   case SfuType::CSRRW:  os << "CSRRW"; break;
   case SfuType::CSRRS:  os << "CSRRS"; break;
   case SfuType::CSRRC:  os << "CSRRC"; break;
+  case SfuType::SHFL:   os << "SHFL"; break;
+  case SfuType::VOTE:   os << "VOTE"; break;
+  case SfuType::REDUCE: os << "REDUCE"; break;
   default: assert(false);
   }
   return os;
@@ -247,25 +289,31 @@ struct MemReq {
   uint32_t tag;
   uint32_t cid;
   uint64_t uuid;
+  AmoType  amo;
 
   MemReq(uint64_t _addr = 0,
           bool _write = false,
           AddrType _type = AddrType::Global,
           uint64_t _tag = 0,
           uint32_t _cid = 0,
-          uint64_t _uuid = 0
+          uint64_t _uuid = 0,
+          AmoType _amo = AmoType::None
   ) : addr(_addr)
     , write(_write)
     , type(_type)
     , tag(_tag)
     , cid(_cid)
     , uuid(_uuid)
+    , amo(_amo)
   {}
 };
 
 inline std::ostream &operator<<(std::ostream &os, const MemReq& req) {
   os << "mem-" << (req.write ? "wr" : "rd") << ": ";
   os << "addr=0x" << std::hex << req.addr << ", type=" << req.type;
+  if (req.amo != AmoType::None) {
+    os << ", amo=" << req.amo;
+  }
   os << std::dec << ", tag=" << req.tag << ", cid=" << req.cid;
   os << " (#" << std::dec << req.uuid << ")";
   return os;
@@ -365,6 +413,71 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// FIFO over a power-of-two ring buffer that only grows,
+// unlike std::queue it does not allocate in steady state.
+template <typename T>
+class RingQueue {
+public:
+  RingQueue(uint32_t capacity = 4)
+    : entries_(1 << log2ceil(std::max<uint32_t>(capacity, 1)))
+    , head_(0)
+    , size_(0)
+  {}
+
+  bool empty() const {
+    return (0 == size_);
+  }
+
+  uint32_t size() const {
+    return size_;
+  }
+
+  T& front() {
+    assert(size_ != 0);
+    return entries_[head_];
+  }
+
+  const T& front() const {
+    assert(size_ != 0);
+    return entries_[head_];
+  }
+
+  void push(const T& value) {
+    if (size_ == entries_.size()) {
+      this->grow();
+    }
+    entries_[(head_ + size_) & (entries_.size() - 1)] = value;
+    ++size_;
+  }
+
+  void pop() {
+    assert(size_ != 0);
+    head_ = (head_ + 1) & (entries_.size() - 1);
+    --size_;
+  }
+
+  void clear() {
+    head_ = 0;
+    size_ = 0;
+  }
+
+private:
+  void grow() {
+    std::vector<T> entries(entries_.size() * 2);
+    for (uint32_t i = 0; i < size_; ++i) {
+      entries[i] = entries_[(head_ + i) & (entries_.size() - 1)];
+    }
+    entries_.swap(entries);
+    head_ = 0;
+  }
+
+  std::vector<T> entries_;
+  uint32_t head_;
+  uint32_t size_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 template <typename Type>
 class Mux : public SimObject<Mux<Type>> {
 public:
@@ -411,8 +524,10 @@ public:
     uint32_t R = num_reqs_;
 
     // skip bypass mode
-    if (I == O)
+    if (I == O) {
+      this->sleep();
       return;
+    }
 
     // process inputs
     for (uint32_t o = 0; o < O; ++o) {
@@ -433,6 +548,13 @@ public:
         }
       }
     }
+
+    // sleep until new inputs arrive
+    for (auto& req_in : Inputs) {
+      if (!req_in.empty())
+        return;
+    }
+    this->sleep();
   }
 
 private:
@@ -504,8 +626,10 @@ public:
     uint32_t R = 1 << lg_num_reqs_;
 
     // skip bypass mode
-    if (I == O)
+    if (I == O) {
+      this->sleep();
       return;
+    }
 
     for (uint32_t o = 0; o < O; ++o) {
       // process incoming responses
@@ -543,6 +667,17 @@ public:
         }
       }
     }
+
+    // sleep until new requests or responses arrive
+    for (auto& req_in : ReqIn) {
+      if (!req_in.empty())
+        return;
+    }
+    for (auto& rsp_out : RspOut) {
+      if (!rsp_out.empty())
+        return;
+    }
+    this->sleep();
   }
 
   void update_cursor(uint32_t index, uint32_t grant) {
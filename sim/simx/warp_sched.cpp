@@ -0,0 +1,122 @@
+// Copyright © 2019-2023
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "warp_sched.h"
+#include <serialize.h>
+
+using namespace vortex;
+
+// first set bit at or after start, wrapping around
+inline int find_first(uint64_t mask, uint32_t start) {
+  if (0 == mask)
+    return -1;
+  uint64_t upper = mask & (~uint64_t(0) << start);
+  return __builtin_ctzll(upper ? upper : mask);
+}
+
+WarpScheduler::WarpScheduler(WarpSchedType type, uint32_t num_warps, uint32_t num_groups)
+  : type_(type)
+  , num_warps_(num_warps)
+  , group_size_((num_warps + num_groups - 1) / num_groups)
+  , group_mask_((group_size_ < 64) ? ((uint64_t(1) << group_size_) - 1) : ~uint64_t(0))
+{
+  assert(num_warps <= 64);
+  this->reset();
+}
+
+void WarpScheduler::reset() {
+  cursor_ = 0;
+  group_ = 0;
+  perf_stats_ = PerfStats();
+}
+
+int WarpScheduler::select(uint64_t ready) {
+  int wid = -1;
+  switch (type_) {
+  case WarpSchedType::Priority:
+    wid = find_first(ready, 0);
+    break;
+  case WarpSchedType::RoundRobin:
+    wid = find_first(ready, cursor_);
+    if (wid != -1 && uint32_t(wid) != cursor_) {
+      ++perf_stats_.misses;
+    }
+    cursor_ = (cursor_ + 1) % num_warps_;
+    break;
+  case WarpSchedType::LooseRoundRobin:
+    wid = find_first(ready, cursor_);
+    if (wid != -1) {
+      if (uint32_t(wid) != cursor_) {
+        ++perf_stats_.misses;
+      }
+      cursor_ = (wid + 1) % num_warps_;
+    }
+    break;
+  case WarpSchedType::GTO:
+    // warps are launched in id order, the lowest id is the oldest
+    if ((ready >> cursor_) & 0x1) {
+      wid = cursor_;
+    } else {
+      wid = find_first(ready, 0);
+      if (wid != -1) {
+        ++perf_stats_.misses;
+        ++perf_stats_.switches;
+        cursor_ = wid;
+      }
+    }
+    break;
+  case WarpSchedType::TwoLevel: {
+    uint32_t group_start = group_ * group_size_;
+    uint64_t group_ready = ready & (group_mask_ << group_start);
+    if (0 == group_ready && 0 != ready) {
+      // the active group is stalled, move to the next one with a ready warp
+      ++perf_stats_.misses;
+      uint32_t num_groups = (num_warps_ + group_size_ - 1) / group_size_;
+      do {
+        group_ = (group_ + 1) % num_groups;
+        group_start = group_ * group_size_;
+        group_ready = ready & (group_mask_ << group_start);
+      } while (0 == group_ready);
+      ++perf_stats_.switches;
+      cursor_ = group_start;
+    }
+    wid = find_first(group_ready, cursor_);
+    if (wid != -1) {
+      cursor_ = (wid + 1) % num_warps_;
+    }
+  } break;
+  default:
+    assert(false);
+  }
+  return wid;
+}
+
+void WarpScheduler::skip(uint64_t cycles) {
+  // round-robin keeps rotating while nothing is ready,
+  // the other policies only move on a selection.
+  if (WarpSchedType::RoundRobin == type_) {
+    cursor_ = (cursor_ + cycles % num_warps_) % num_warps_;
+  }
+}
+
+void WarpScheduler::save(std::ostream& os) const {
+  serialize(os, cursor_);
+  serialize(os, group_);
+  serialize(os, perf_stats_);
+}
+
+void WarpScheduler::load(std::istream& is) {
+  deserialize(is, cursor_);
+  deserialize(is, group_);
+  deserialize(is, perf_stats_);
+}
@@ -0,0 +1,88 @@
+// Copyright © 2019-2023
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <assert.h>
+
+namespace vortex {
+
+enum class WarpSchedType {
+  Priority,         // lowest ready warp first
+  RoundRobin,       // the first choice rotates by one warp every cycle
+  LooseRoundRobin,  // resume after the last issued warp
+  GTO,              // greedy on the last issued warp, then the oldest
+  TwoLevel          // loose round-robin within the active warp group
+};
+
+inline std::ostream &operator<<(std::ostream &os, const WarpSchedType& type) {
+  switch (type) {
+  case WarpSchedType::Priority:        os << "Priority"; break;
+  case WarpSchedType::RoundRobin:      os << "RoundRobin"; break;
+  case WarpSchedType::LooseRoundRobin: os << "LooseRoundRobin"; break;
+  case WarpSchedType::GTO:             os << "GTO"; break;
+  case WarpSchedType::TwoLevel:        os << "TwoLevel"; break;
+  default: assert(false);
+  }
+  return os;
+}
+
+// picks the next warp to issue from the mask of ready warps
+class WarpScheduler {
+public:
+  struct PerfStats {
+    uint64_t misses;    // the policy's first choice was not ready
+    uint64_t switches;  // changes of GTO's greedy warp or of the two-level active group
+
+    PerfStats()
+      : misses(0)
+      , switches(0)
+    {}
+  };
+
+  WarpScheduler(WarpSchedType type, uint32_t num_warps, uint32_t num_groups);
+
+  void reset();
+
+  // returns the selected warp, or -1 if none is ready
+  int select(uint64_t ready);
+
+  // accounts for cycles skipped with no ready warp
+  void skip(uint64_t cycles);
+
+  WarpSchedType type() const {
+    return type_;
+  }
+
+  void save(std::ostream& os) const;
+
+  void load(std::istream& is);
+
+  const PerfStats& perf_stats() const {
+    return perf_stats_;
+  }
+
+private:
+
+  WarpSchedType type_;
+  uint32_t num_warps_;
+  uint32_t group_size_;
+  uint64_t group_mask_;
+  uint32_t cursor_;
+  uint32_t group_;
+  PerfStats perf_stats_;
+};
+
+}
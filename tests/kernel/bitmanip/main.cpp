@@ -0,0 +1,140 @@
+#include <stdint.h>
+#include <VX_types.h>
+#include <vx_intrinsics.h>
+#include <vx_print.h>
+
+// Compares the instructions retired by the base ISA and the Zba/Zbb/Zbs
+// sequences of the index math used by the state-vector and spawn code.
+
+const int Num = 1024;
+
+uint32_t buffer[Num];
+
+typedef size_t (*bench_fn)(int);
+
+// insert a zero bit at position k of each index i
+size_t __attribute__((noinline)) insert_bit_base(int k) {
+	size_t mask = (size_t(1) << k) - 1;
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		sum += ((i >> k) << (k + 1)) | (i & mask);
+	}
+	return sum;
+}
+
+size_t __attribute__((noinline)) insert_bit_zb(int k) {
+	size_t mask = (size_t(1) << k) - 1;
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		sum += vx_sh1add(vx_andn(i, mask), i & mask);
+	}
+	return sum;
+}
+
+// visit the set bits of each mask
+size_t __attribute__((noinline)) bit_loop_base(int seed) {
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		size_t bits = i * seed;
+		while (bits) {
+			sum += __builtin_ctzl(bits);
+			bits &= bits - 1;
+		}
+	}
+	return sum;
+}
+
+size_t __attribute__((noinline)) bit_loop_zb(int seed) {
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		size_t bits = i * seed;
+		while (bits) {
+			size_t index = vx_ctz(bits);
+			sum += index;
+			bits = vx_bclr(bits, index);
+		}
+	}
+	return sum;
+}
+
+// count the set bits of each mask
+size_t __attribute__((noinline)) popcount_base(int seed) {
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		sum += __builtin_popcountl(i * seed);
+	}
+	return sum;
+}
+
+size_t __attribute__((noinline)) popcount_zb(int seed) {
+	size_t sum = 0;
+	for (size_t i = 0; i < Num; ++i) {
+		sum += vx_cpop(i * seed);
+	}
+	return sum;
+}
+
+// per-task address and warp/thread split, as in the spawn callbacks
+size_t __attribute__((noinline)) task_index_base(int num_threads) {
+	size_t log_threads = 0;
+	while ((size_t(1) << log_threads) < size_t(num_threads)) {
+		++log_threads;
+	}
+	size_t sum = 0;
+	for (size_t task_id = 0; task_id < Num; ++task_id) {
+		size_t warp_id = task_id >> log_threads;
+		size_t thread_id = task_id & (num_threads - 1);
+		buffer[task_id] = warp_id + thread_id;
+		sum += buffer[thread_id];
+	}
+	return sum;
+}
+
+size_t __attribute__((noinline)) task_index_zb(int num_threads) {
+	size_t log_threads = vx_ctz(num_threads);
+	size_t base = size_t(buffer);
+	size_t sum = 0;
+	for (size_t task_id = 0; task_id < Num; ++task_id) {
+		size_t warp_id = task_id >> log_threads;
+		size_t thread_id = vx_andn(task_id, size_t(-1) << log_threads);
+		*(uint32_t*)vx_sh2add(task_id, base) = warp_id + thread_id;
+		sum += *(uint32_t*)vx_sh2add(thread_id, base);
+	}
+	return sum;
+}
+
+int run(const char* name, bench_fn base_fn, bench_fn zb_fn, int arg) {
+	size_t start = csr_read(VX_CSR_MINSTRET);
+	size_t ref = base_fn(arg);
+	size_t base_instrs = csr_read(VX_CSR_MINSTRET) - start;
+
+	start = csr_read(VX_CSR_MINSTRET);
+	size_t value = zb_fn(arg);
+	size_t zb_instrs = csr_read(VX_CSR_MINSTRET) - start;
+
+	vx_printf("%s: base=%d, zb=%d instructions (%d%%)\n", name,
+		int(base_instrs), int(zb_instrs), int((zb_instrs * 100) / base_instrs));
+
+	if (value != ref) {
+		vx_printf("Failed! value=%d, expected=%d\n", int(value), int(ref));
+		return 1;
+	}
+	return 0;
+}
+
+int main() {
+	int errors = 0;
+
+	errors += run("insert_bit", insert_bit_base, insert_bit_zb, 5);
+	errors += run("bit_loop", bit_loop_base, bit_loop_zb, 0x9e37);
+	errors += run("popcount", popcount_base, popcount_zb, 0x9e37);
+	errors += run("task_index", task_index_base, task_index_zb, vx_num_threads());
+
+	if (0 == errors) {
+		vx_printf("Passed!\n");
+	} else {
+		vx_printf("Failed!\n");
+	}
+
+	return errors;
+}
@@ -0,0 +1,56 @@
+#include <stdint.h>
+#include <vx_intrinsics.h>
+#include <vx_print.h>
+
+// Patches a function in the code segment with a store and an atomic and
+// checks that the next call runs the new instructions.
+
+extern "C" int patch_fn();
+
+asm(
+	".section .text.patch_fn, \"ax\"\n"
+	".align 2\n"
+	".globl patch_fn\n"
+	"patch_fn:\n"
+	"	addi a0, zero, 1\n"
+	"	ret\n"
+	".text\n"
+);
+
+#define ADDI_A0(imm) ((uint32_t(imm) << 20) | 0x00000513)
+
+inline void fence_i() {
+	asm volatile (".insn i 0x0f, 1, x0, x0, 0" ::: "memory");
+}
+
+int check(const char* name, int value, int expected) {
+	if (value != expected) {
+		vx_printf("%s: Failed! value=%d, expected=%d\n", name, value, expected);
+		return 1;
+	}
+	vx_printf("%s: Passed!\n", name);
+	return 0;
+}
+
+int main() {
+	int errors = 0;
+	auto code = (volatile uint32_t*)&patch_fn;
+
+	errors += check("original", patch_fn(), 1);
+
+	*code = ADDI_A0(2);
+	fence_i();
+	errors += check("store", patch_fn(), 2);
+
+	__sync_fetch_and_add(code, ADDI_A0(1));
+	fence_i();
+	errors += check("amo", patch_fn(), 3);
+
+	if (0 == errors) {
+		vx_printf("Passed!\n");
+	} else {
+		vx_printf("Failed!\n");
+	}
+
+	return errors;
+}
@@ -421,7 +421,46 @@ void kernel_gbar(int task_id, kernel_arg_t* __UNIFORM__ arg) {
 	dst_ptr[task_id] += 1;
 }
 
-static PFN_Kernel sc_tests[24];
+void kernel_shfl(int task_id, kernel_arg_t* __UNIFORM__ arg) {
+	auto count    = arg->task_size;
+	auto src0_ptr = (int32_t*)arg->src0_addr;
+	auto dst_ptr  = (int32_t*)arg->dst_addr;
+	auto offset   = task_id * count;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t a = src0_ptr[offset+i];
+		int32_t c = vx_shfl_idx(a, 0) + vx_shfl_up(a, 1) + vx_shfl_down(a, 2) + vx_shfl_xor(a, 1);
+		dst_ptr[offset+i] = c;
+	}
+}
+
+void kernel_vote(int task_id, kernel_arg_t* __UNIFORM__ arg) {
+	auto count    = arg->task_size;
+	auto src0_ptr = (int32_t*)arg->src0_addr;
+	auto dst_ptr  = (uint32_t*)arg->dst_addr;
+	auto offset   = task_id * count;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t p = src0_ptr[offset+i] & 0x1;
+		uint32_t c = vx_vote_ballot(p) + vx_vote_any(p) + vx_vote_all(p);
+		dst_ptr[offset+i] = c;
+	}
+}
+
+void kernel_reduce(int task_id, kernel_arg_t* __UNIFORM__ arg) {
+	auto count    = arg->task_size;
+	auto src0_ptr = (int32_t*)arg->src0_addr;
+	auto dst_ptr  = (int32_t*)arg->dst_addr;
+	auto offset   = task_id * count;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t a = src0_ptr[offset+i];
+		int32_t c = vx_reduce_add(a);
+		dst_ptr[offset+i] = c;
+	}
+}
+
+static PFN_Kernel sc_tests[27];
 void register_tests() {
 	sc_tests[0] = kernel_iadd;
 	sc_tests[1] = kernel_imul;
@@ -447,6 +486,9 @@ void register_tests() {
 	sc_tests[21] = kernel_trigo;
 	sc_tests[22] = kernel_bar;
 	sc_tests[23] = kernel_gbar;
+	sc_tests[24] = kernel_shfl;
+	sc_tests[25] = kernel_vote;
+	sc_tests[26] = kernel_reduce;
 }
 
 int main() {
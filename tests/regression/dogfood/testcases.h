@@ -869,6 +869,143 @@ public:
   uint64_t num_threads_;
 };
 
+class Test_SHFL : public ITestCase {
+public:
+  Test_SHFL(TestSuite* suite) : ITestCase(suite, "shfl") {}
+
+  int setup(uint32_t n, void* src1, void* /*src2*/) override {
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_CORES, &num_cores_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_WARPS, &num_warps_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_THREADS, &num_threads_));
+    auto a = (int32_t*)src1;
+    for (uint32_t i = 0; i < n; ++i) {
+      a[i] = n/2 - i * 3;
+    }
+    return 0;
+  }
+
+  int verify(uint32_t n, void* dst, const void* src1, const void* /*src2*/) override {
+    int errors = 0;
+    auto a = (int32_t*)src1;
+    auto c = (int32_t*)dst;
+    uint32_t num_threads = num_threads_;
+    uint32_t count = n / (num_cores_ * num_warps_ * num_threads);
+    for (uint32_t i = 0; i < n; ++i) {
+      uint32_t task = i / count;
+      uint32_t lane = task % num_threads;
+      auto lane_value = [&](uint32_t src) {
+        if (src >= num_threads)
+          return a[i];
+        return a[(task - lane + src) * count + (i % count)];
+      };
+      int32_t ref = lane_value(0)
+                  + lane_value((lane >= 1) ? (lane - 1) : num_threads)
+                  + lane_value(lane + 2)
+                  + lane_value(lane ^ 1);
+      if (c[i] != ref) {
+        std::cout << "error at result #" << i << ": expected=" << ref << ", actual=" << c[i] << ", a=" << a[i] << std::endl;
+        ++errors;
+      }
+    }
+    return errors;
+  }
+
+  uint64_t num_cores_;
+  uint64_t num_warps_;
+  uint64_t num_threads_;
+};
+
+class Test_VOTE : public ITestCase {
+public:
+  Test_VOTE(TestSuite* suite) : ITestCase(suite, "vote") {}
+
+  int setup(uint32_t n, void* src1, void* /*src2*/) override {
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_CORES, &num_cores_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_WARPS, &num_warps_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_THREADS, &num_threads_));
+    auto a = (int32_t*)src1;
+    for (uint32_t i = 0; i < n; ++i) {
+      // mix of all-set, none-set and divergent predicates
+      switch ((i / 8) % 3) {
+      case 0: a[i] = 1; break;
+      case 1: a[i] = 0; break;
+      default: a[i] = (i * 7) >> 2; break;
+      }
+    }
+    return 0;
+  }
+
+  int verify(uint32_t n, void* dst, const void* src1, const void* /*src2*/) override {
+    int errors = 0;
+    auto a = (int32_t*)src1;
+    auto c = (uint32_t*)dst;
+    uint32_t num_threads = num_threads_;
+    uint32_t count = n / (num_cores_ * num_warps_ * num_threads);
+    for (uint32_t i = 0; i < n; ++i) {
+      uint32_t task = i / count;
+      uint32_t base = task - (task % num_threads);
+      uint32_t ballot = 0;
+      for (uint32_t t = 0; t < num_threads; ++t) {
+        if (a[(base + t) * count + (i % count)] & 0x1) {
+          ballot |= (1u << t);
+        }
+      }
+      uint32_t all_mask = (num_threads < 32) ? ((1u << num_threads) - 1) : 0xffffffff;
+      uint32_t ref = ballot + (ballot != 0) + (ballot == all_mask);
+      if (c[i] != ref) {
+        std::cout << "error at result #" << i << ": expected=" << std::hex << ref << ", actual=" << c[i] << std::endl;
+        ++errors;
+      }
+    }
+    return errors;
+  }
+
+  uint64_t num_cores_;
+  uint64_t num_warps_;
+  uint64_t num_threads_;
+};
+
+class Test_REDUCE : public ITestCase {
+public:
+  Test_REDUCE(TestSuite* suite) : ITestCase(suite, "reduce") {}
+
+  int setup(uint32_t n, void* src1, void* /*src2*/) override {
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_CORES, &num_cores_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_WARPS, &num_warps_));
+    RT_CHECK(vx_dev_caps(suite_->device(), VX_CAPS_NUM_THREADS, &num_threads_));
+    auto a = (int32_t*)src1;
+    for (uint32_t i = 0; i < n; ++i) {
+      a[i] = n/2 - i;
+    }
+    return 0;
+  }
+
+  int verify(uint32_t n, void* dst, const void* src1, const void* /*src2*/) override {
+    int errors = 0;
+    auto a = (int32_t*)src1;
+    auto c = (int32_t*)dst;
+    uint32_t num_threads = num_threads_;
+    uint32_t count = n / (num_cores_ * num_warps_ * num_threads);
+    for (uint32_t i = 0; i < n; ++i) {
+      uint32_t task = i / count;
+      uint32_t base = task - (task % num_threads);
+      int32_t ref = 0;
+      for (uint32_t t = 0; t < num_threads; ++t) {
+        ref += a[(base + t) * count + (i % count)];
+      }
+      if (c[i] != ref) {
+        std::cout << "error at result #" << i << ": expected=" << ref << ", actual=" << c[i] << std::endl;
+        ++errors;
+      }
+    }
+    return errors;
+  }
+
+  uint64_t num_cores_;
+  uint64_t num_warps_;
+  uint64_t num_threads_;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 TestSuite::TestSuite(vx_device_h device)
@@ -897,6 +1034,9 @@ TestSuite::TestSuite(vx_device_h device)
   this->add_test(new Test_TRIGO(this));
   this->add_test(new Test_BAR(this));
   this->add_test(new Test_GBAR(this));
+  this->add_test(new Test_SHFL(this));
+  this->add_test(new Test_VOTE(this));
+  this->add_test(new Test_REDUCE(this));
 }
 
 TestSuite::~TestSuite() {
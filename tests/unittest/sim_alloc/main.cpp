@@ -0,0 +1,185 @@
+#include <simobject.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+// count every heap allocation made through the C++ allocator
+static uint64_t alloc_count = 0;
+
+void* operator new(size_t size) {
+  ++alloc_count;
+  auto ptr = malloc(size);
+  if (nullptr == ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+#define CHECK(_cond)                                            \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     return -1;                                                 \
+   } while (false)
+
+class Producer : public SimObject<Producer> {
+public:
+  SimPort<uint32_t> Output;
+
+  Producer(const SimContext& ctx, const char* name, uint32_t delay) 
+    : SimObject<Producer>(ctx, name)
+    , Output(this)
+    , delay_(delay)
+    , value_(0)
+  {}
+
+  void reset() {
+    value_ = 0;
+  }
+
+  void tick() {
+    if (Output.full())
+      return;
+    Output.push(value_++, delay_);
+  }
+
+private:
+  uint32_t delay_;
+  uint32_t value_;
+};
+
+class Consumer : public SimObject<Consumer> {
+public:
+  SimPort<uint32_t> Input;
+
+  Consumer(const SimContext& ctx, const char* name, uint32_t capacity = 0, uint32_t interval = 0) 
+    : SimObject<Consumer>(ctx, name)
+    , Input(this, capacity)
+    , interval_(interval)
+    , ticks_(0)
+    , received_(0)
+    , errors_(0)
+  {}
+
+  void reset() {
+    ticks_ = 0;
+    received_ = 0;
+    errors_ = 0;
+  }
+
+  void tick() {
+    if (interval_ != 0) {
+      // drain a single packet every 'interval' cycles
+      if (0 == (ticks_++ % interval_) && !Input.empty()) {
+        errors_ += (Input.front() != received_);
+        ++received_;
+        Input.pop();
+      }
+      return;
+    }
+    while (!Input.empty()) {
+      errors_ += (Input.front() != received_);
+      ++received_;
+      Input.pop();
+    }
+  }
+
+  uint32_t received() const {
+    return received_;
+  }
+
+  uint32_t errors() const {
+    return errors_;
+  }
+
+private:
+  uint32_t interval_;
+  uint32_t ticks_;
+  uint32_t received_;
+  uint32_t errors_;
+};
+
+class Caller : public SimObject<Caller> {
+public:
+  Caller(const SimContext& ctx, const char* name) 
+    : SimObject<Caller>(ctx, name)
+    , calls_(0)
+  {}
+
+  void reset() {
+    calls_ = 0;
+  }
+
+  void tick() {
+    this->platform().schedule([this](const uint32_t& value) {
+      calls_ += value;
+    }, 1u, 3);
+  }
+
+  uint32_t calls() const {
+    return calls_;
+  }
+
+private:
+  uint32_t calls_;
+};
+
+int main() {
+  const uint32_t warmup = 2000;
+  const uint32_t cycles = 10000;
+
+  // short, medium and beyond-the-wheel delays
+  const uint32_t delays[] = {1, 7, 1000};
+
+  SimPlatform platform;
+  auto& ctx = platform.context();
+
+  std::vector<Producer::Ptr> producers;
+  std::vector<Consumer::Ptr> consumers;
+  for (auto delay : delays) {
+    auto producer = Producer::Create(ctx, "producer", delay);
+    auto consumer = Consumer::Create(ctx, "consumer");
+    producer->Output.bind(&consumer->Input);
+    producers.push_back(producer);
+    consumers.push_back(consumer);
+  }
+  auto caller = Caller::Create(ctx, "caller");
+
+  // fixed-capacity port drained at half rate: the producer gets backpressured
+  auto bounded_producer = Producer::Create(ctx, "bounded_producer", 3);
+  auto bounded_consumer = Consumer::Create(ctx, "bounded_consumer", 4, 2);
+  bounded_producer->Output.bind(&bounded_consumer->Input);
+
+  platform.reset();
+
+  for (uint32_t i = 0; i < warmup; ++i) {
+    platform.tick();
+  }
+
+  auto allocs = alloc_count;
+  for (uint32_t i = 0; i < cycles; ++i) {
+    platform.tick();
+  }
+  allocs = alloc_count - allocs;
+
+  printf("heap allocations over %d cycles: %ld\n", cycles, allocs);
+  CHECK(allocs == 0);
+
+  for (uint32_t i = 0; i < consumers.size(); ++i) {
+    CHECK(consumers.at(i)->errors() == 0);
+    CHECK(consumers.at(i)->received() == (warmup + cycles - delays[i]));
+  }
+  CHECK(caller->calls() == (warmup + cycles - 3));
+  CHECK(bounded_consumer->errors() == 0);
+  CHECK(bounded_consumer->received() + 3 >= (warmup + cycles) / 2);
+
+  platform.finalize();
+
+  printf("PASSED!\n");
+
+  return 0;
+}
@@ -0,0 +1,257 @@
+#include <simobject.h>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(_cond)                                            \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     return -1;                                                 \
+   } while (false)
+
+// packets are tagged with their source node
+struct packet_t {
+  uint32_t src;
+  uint32_t value;
+};
+
+// forwards every packet to the next node of the ring
+class Hub : public SimObject<Hub> {
+public:
+  std::vector<SimPort<packet_t>> Inputs;
+  std::vector<SimPort<packet_t>> Outputs;
+
+  Hub(const SimContext& ctx, const char* name, uint32_t num_nodes)
+    : SimObject<Hub>(ctx, name)
+    , Inputs(num_nodes, this)
+    , Outputs(num_nodes, this)
+  {}
+
+  void reset() {}
+
+  void tick() {
+    for (uint32_t i = 0, n = Inputs.size(); i < n; ++i) {
+      auto& input = Inputs.at(i);
+      if (input.empty())
+        continue;
+      Outputs.at((i + 1) % n).push(input.front(), 1 + (i % 3));
+      input.pop();
+    }
+  }
+};
+
+class Node : public SimObject<Node> {
+public:
+  SimPort<packet_t> Input;
+  SimPort<packet_t> Output;
+
+  // the log is shared by all nodes and written from tock(),
+  // its order must not depend on threading.
+  Node(const SimContext& ctx, const char* name, uint32_t id, std::vector<uint64_t>* log)
+    : SimObject<Node>(ctx, name)
+    , Input(this)
+    , Output(this)
+    , id_(id)
+    , log_(log)
+  {}
+
+  void reset() {
+    seed_ = id_ + 1;
+    checksum_ = 0;
+    received_ = 0;
+  }
+
+  void tick() {
+    while (!Input.empty()) {
+      auto& pkt = Input.front();
+      checksum_ = checksum_ * 31 + pkt.src * 7 + pkt.value;
+      ++received_;
+      Input.pop();
+    }
+    seed_ = seed_ * 1103515245 + 12345;
+    if (seed_ & 0x100) {
+      Output.push({id_, seed_ >> 16}, 1 + ((seed_ >> 8) & 3));
+    }
+    if (seed_ & 0x200) {
+      this->request_tock();
+    }
+  }
+
+  void tock() {
+    log_->push_back((uint64_t(id_) << 32) | (checksum_ + log_->size()));
+  }
+
+  uint32_t checksum() const {
+    return checksum_;
+  }
+
+  uint32_t received() const {
+    return received_;
+  }
+
+private:
+  uint32_t id_;
+  std::vector<uint64_t>* log_;
+  uint32_t seed_;
+  uint32_t checksum_;
+  uint32_t received_;
+};
+
+struct result_t {
+  std::vector<uint32_t> checksums;
+  std::vector<uint32_t> received;
+  std::vector<uint64_t> log;
+};
+
+// one partition per node, the hub is in the first one
+static std::vector<Node::Ptr> create_ring(SimPlatform& platform, uint32_t num_nodes, std::vector<uint64_t>* log) {
+  auto hub = Hub::Create(platform.context(), "hub", num_nodes);
+  std::vector<Node::Ptr> nodes;
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    platform.new_partition();
+    auto node = Node::Create(platform.context(), "node", i, log);
+    node->Output.bind(&hub->Inputs.at(i));
+    hub->Outputs.at(i).bind(&node->Input);
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+static result_t simulate(uint32_t num_threads, uint32_t num_nodes, uint32_t cycles) {
+  SimPlatform platform;
+  platform.set_num_threads(num_threads);
+
+  result_t result;
+  auto nodes = create_ring(platform, num_nodes, &result.log);
+
+  platform.reset();
+  for (uint32_t i = 0; i < cycles; ++i) {
+    platform.tick();
+  }
+
+  for (auto& node : nodes) {
+    result.checksums.push_back(node->checksum());
+    result.received.push_back(node->received());
+  }
+
+  platform.finalize();
+  return result;
+}
+
+// streams packets into another partition, nothing flows back
+class Source : public SimObject<Source> {
+public:
+  SimPort<packet_t> Output;
+
+  Source(const SimContext& ctx, const char* name)
+    : SimObject<Source>(ctx, name)
+    , Output(this)
+  {}
+
+  void reset() {
+    count_ = 0;
+  }
+
+  void tick() {
+    Output.push({0, count_}, 1 + (count_ & 3));
+    ++count_;
+  }
+
+private:
+  uint32_t count_;
+};
+
+class Sink : public SimObject<Sink> {
+public:
+  SimPort<packet_t> Input;
+
+  Sink(const SimContext& ctx, const char* name)
+    : SimObject<Sink>(ctx, name)
+    , Input(this)
+  {}
+
+  void reset() {}
+
+  void tick() {
+    while (!Input.empty()) {
+      Input.pop();
+    }
+  }
+};
+
+// events crossing partitions go back to the pool they came from,
+// the slabs held by the event pools stop growing once warmed up.
+static uint32_t pool_growth(uint32_t num_threads, uint32_t cycles) {
+  SimPlatform platform;
+  platform.set_num_threads(num_threads);
+
+  auto source = Source::Create(platform.context(), "source");
+  platform.new_partition();
+  auto sink = Sink::Create(platform.context(), "sink");
+  source->Output.bind(&sink->Input);
+
+  platform.reset();
+  for (uint32_t i = 0; i < cycles; ++i) {
+    platform.tick();
+  }
+
+  auto warm_slabs = MemoryPool<SimPortEvent<packet_t>>::thread_slabs();
+  for (uint32_t i = 0; i < 10 * cycles; ++i) {
+    platform.tick();
+  }
+  auto slabs = MemoryPool<SimPortEvent<packet_t>>::thread_slabs();
+
+  platform.finalize();
+  return slabs - warm_slabs;
+}
+
+int main() {
+  const uint32_t num_nodes = 8;
+  const uint32_t cycles = 20000;
+
+  auto serial = simulate(1, num_nodes, cycles);
+
+  uint32_t total = 0;
+  for (auto received : serial.received) {
+    total += received;
+  }
+  printf("packets delivered over %d cycles: %d\n", cycles, total);
+  CHECK(total != 0);
+  CHECK(!serial.log.empty());
+
+  for (uint32_t num_threads : {2, 3, 8}) {
+    auto parallel = simulate(num_threads, num_nodes, cycles);
+    CHECK(parallel.checksums == serial.checksums);
+    CHECK(parallel.received == serial.received);
+    CHECK(parallel.log == serial.log);
+  }
+
+  // independent platforms simulated concurrently, each from its own thread
+  std::vector<result_t> results(4);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      results.at(i) = simulate(1 + (i % 2), num_nodes, cycles);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& result : results) {
+    CHECK(result.checksums == serial.checksums);
+    CHECK(result.received == serial.received);
+    CHECK(result.log == serial.log);
+  }
+
+  for (uint32_t num_threads : {1, 2, 8}) {
+    auto growth = pool_growth(num_threads, cycles);
+    printf("event pool growth with %d threads: %d slabs\n", num_threads, growth);
+    CHECK(growth == 0);
+  }
+
+  printf("PASSED!\n");
+
+  return 0;
+}
@@ -0,0 +1,364 @@
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace vortex;
+
+#define CHECK(_cond)                                            \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     return -1;                                                 \
+   } while (false)
+
+static const uint32_t PAGE_SIZE = 4096;
+
+// value of the bytes never written
+static uint8_t uninit_byte(uint64_t addr) {
+  return (0xbaadf00d >> ((addr & 0x3) * 8)) & 0xff;
+}
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double bandwidth(uint64_t size, double ms) {
+  return (size / (1024.0 * 1024.0)) / (ms / 1000.0);
+}
+
+int test_copies() {
+  const uint64_t mem_size = 64 * PAGE_SIZE;
+  RAM ram(0, PAGE_SIZE);
+  std::vector<uint8_t> ref(mem_size);
+  for (uint64_t i = 0; i < mem_size; ++i) {
+    ref[i] = uninit_byte(i);
+  }
+
+  std::vector<uint8_t> src(4 * PAGE_SIZE);
+  std::vector<uint8_t> dst(4 * PAGE_SIZE);
+  srand(11);
+  for (int n = 0; n < 2000; ++n) {
+    uint64_t size = (n & 1) ? (1 << (rand() % 4)) : (rand() % src.size());
+    uint64_t addr = rand() % (mem_size - size);
+    for (uint64_t i = 0; i < size; ++i) {
+      src[i] = rand();
+    }
+    if (rand() & 1) {
+      ram.write(src.data(), addr, size);
+      memcpy(ref.data() + addr, src.data(), size);
+    } else {
+      ram.read(dst.data(), addr, size);
+      CHECK(0 == memcmp(dst.data(), ref.data() + addr, size));
+    }
+  }
+
+  // whole pages written first are not initialized
+  ram.write(src.data(), 8 * PAGE_SIZE + 16, 2 * PAGE_SIZE);
+  memcpy(ref.data() + 8 * PAGE_SIZE + 16, src.data(), 2 * PAGE_SIZE);
+
+  for (uint64_t i = 0; i < mem_size; ++i) {
+    CHECK(ram[i] == ref[i]);
+  }
+  return 0;
+}
+
+int test_bounds() {
+  RAM ram(16 * PAGE_SIZE, PAGE_SIZE);
+  std::vector<uint8_t> buf(4 * PAGE_SIZE);
+
+  bool failed = false;
+  try {
+    ram.write(buf.data(), 14 * PAGE_SIZE, buf.size());
+  } catch (const OutOfRange&) {
+    failed = true;
+  }
+  CHECK(failed);
+
+  ram.set_acl(0, 4 * PAGE_SIZE, 0x3);
+  ram.set_acl(4 * PAGE_SIZE, 4 * PAGE_SIZE, 0x1);
+  ram.enable_acl(true);
+  ram.write(buf.data(), 0, 4 * PAGE_SIZE);
+  ram.read(buf.data(), 2 * PAGE_SIZE, 4 * PAGE_SIZE);
+
+  // the range is checked before any byte is copied
+  uint8_t marker = 0x5a;
+  ram.write(&marker, 4 * PAGE_SIZE - 1, 1);
+  buf.assign(buf.size(), 0);
+  failed = false;
+  try {
+    ram.write(buf.data(), 3 * PAGE_SIZE, 2 * PAGE_SIZE);
+  } catch (const BadAddress&) {
+    failed = true;
+  }
+  CHECK(failed);
+  CHECK(ram[4 * PAGE_SIZE - 1] == marker);
+  return 0;
+}
+
+int bench_bandwidth(uint64_t size) {
+  std::vector<uint8_t> src(size);
+  std::vector<uint8_t> dst(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    src[i] = i * 7;
+  }
+
+  // byte accesses, as each copy used to be done
+  {
+    RAM ram(0, PAGE_SIZE);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < size; ++i) {
+      ram[i] = src[i];
+    }
+    double write_ms = elapsed_ms(start);
+    start = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < size; ++i) {
+      dst[i] = ram[i];
+    }
+    double read_ms = elapsed_ms(start);
+    CHECK(src == dst);
+    printf("byte copy: write=%.1f MB/s, read=%.1f MB/s\n", bandwidth(size, write_ms), bandwidth(size, read_ms));
+  }
+
+  // page-span copies
+  {
+    RAM ram(0, PAGE_SIZE);
+    auto start = std::chrono::high_resolution_clock::now();
+    ram.write(src.data(), 0, size);
+    double write_ms = elapsed_ms(start);
+    dst.assign(size, 0);
+    start = std::chrono::high_resolution_clock::now();
+    ram.read(dst.data(), 0, size);
+    double read_ms = elapsed_ms(start);
+    CHECK(src == dst);
+    printf("bulk copy: write=%.1f MB/s, read=%.1f MB/s\n", bandwidth(size, write_ms), bandwidth(size, read_ms));
+
+    // word accesses, as issued by the emulator
+    uint64_t sum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < size; i += 4) {
+      uint32_t value;
+      ram.read(&value, i, 4);
+      sum += value;
+    }
+    read_ms = elapsed_ms(start);
+    uint64_t ref = 0;
+    for (uint64_t i = 0; i < size; i += 4) {
+      uint32_t value;
+      memcpy(&value, src.data() + i, 4);
+      ref += value;
+    }
+    CHECK(sum == ref);
+    printf("word read: %.1f MB/s\n", bandwidth(size, read_ms));
+
+    // word accesses interleaved across pages, as issued by concurrent warps
+    sum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (uint64_t offset = 0; offset < PAGE_SIZE; offset += 4) {
+      for (uint64_t i = offset; i < size; i += PAGE_SIZE) {
+        uint32_t value;
+        ram.read(&value, i, 4);
+        sum += value;
+      }
+    }
+    read_ms = elapsed_ms(start);
+    CHECK(sum == ref);
+    printf("scattered word read: %.1f MB/s\n", bandwidth(size, read_ms));
+  }
+  return 0;
+}
+
+int test_map_file() {
+  char filename[] = "/tmp/sim_ram_XXXXXX";
+  int fd = mkstemp(filename);
+  CHECK(fd >= 0);
+  unlink(filename);
+  std::vector<uint8_t> content(5 * PAGE_SIZE + 100);
+  for (uint64_t i = 0; i < content.size(); ++i) {
+    content[i] = i * 13;
+  }
+  CHECK(write(fd, content.data(), content.size()) == (ssize_t)content.size());
+
+  // aligned, partly aligned and misaligned destinations
+  uint64_t dests[] = {0x10000, 0x20000 + 64, 0x30000 + 64};
+  uint64_t offsets[] = {0, 64, 0};
+  for (int n = 0; n < 3; ++n) {
+    RAM ram(0, PAGE_SIZE);
+    uint64_t dest = dests[n];
+    uint64_t size = content.size() - offsets[n];
+    ram.map_file(fd, offsets[n], size, dest);
+    for (uint64_t i = 0; i < size; ++i) {
+      CHECK(ram[dest + i] == content[offsets[n] + i]);
+    }
+    CHECK(ram[dest - 1] == uninit_byte(dest - 1));
+    CHECK(ram[dest + size] == uninit_byte(dest + size));
+
+    // writes stay private to the device memory
+    uint32_t value = 0xdeadbeef;
+    ram.write(&value, dest + PAGE_SIZE, 4);
+    CHECK(ram[dest + PAGE_SIZE] == 0xef);
+    uint8_t byte;
+    CHECK(pread(fd, &byte, 1, offsets[n] + PAGE_SIZE) == 1);
+    CHECK(byte == content[offsets[n] + PAGE_SIZE]);
+  }
+  close(fd);
+  return 0;
+}
+
+int test_snapshot() {
+  const uint64_t mem_size = 64 * PAGE_SIZE;
+  RAM ram(0, PAGE_SIZE);
+  const RAM& cram = ram; // reads through a const reference do not copy pages
+  std::vector<uint8_t> ref(2 * mem_size);
+  for (uint64_t i = 0; i < ref.size(); ++i) {
+    ref[i] = uninit_byte(i);
+  }
+
+  std::vector<uint8_t> src(2 * PAGE_SIZE);
+  srand(23);
+  auto random_writes = [&](uint64_t limit, std::vector<uint8_t>* mirror) {
+    for (int n = 0; n < 200; ++n) {
+      uint64_t size = 1 + rand() % src.size();
+      uint64_t addr = rand() % (limit - size);
+      for (uint64_t i = 0; i < size; ++i) {
+        src[i] = rand();
+      }
+      ram.write(src.data(), addr, size);
+      if (mirror) {
+        memcpy(mirror->data() + addr, src.data(), size);
+      }
+    }
+  };
+
+  random_writes(mem_size, &ref);
+  uint64_t size = ram.size();
+  CHECK(!ram.restore());
+  ram.snapshot();
+
+  for (int k = 0; k < 2; ++k) {
+    // dirty existing pages and allocate new ones past the snapshot
+    random_writes(2 * mem_size, nullptr);
+    ram.restore();
+    CHECK(ram.size() == size);
+    for (uint64_t i = 0; i < mem_size; ++i) {
+      CHECK(cram[i] == ref[i]);
+    }
+    CHECK(ram.size() == size);
+  }
+
+  // a new snapshot keeps the current content
+  random_writes(mem_size, &ref);
+  ram.snapshot();
+  random_writes(mem_size, nullptr);
+  ram.restore();
+  for (uint64_t i = 0; i < mem_size; ++i) {
+    CHECK(cram[i] == ref[i]);
+  }
+  return 0;
+}
+
+int test_acl() {
+  const uint64_t mem_size = 32 * PAGE_SIZE;
+  ACLManager acl(PAGE_SIZE);
+  std::vector<uint8_t> ref(mem_size, 0xff);
+
+  // violations are reported on stdout
+  std::stringstream log;
+  auto cout_buf = std::cout.rdbuf(log.rdbuf());
+
+  srand(37);
+  int failed = 0;
+  for (int n = 0; n < 20000 && !failed; ++n) {
+    uint64_t size = 1 + ((n & 1) ? (rand() % 64) : (rand() % (4 * PAGE_SIZE)));
+    uint64_t addr = rand() % (mem_size - size);
+    int flags = rand() % 4;
+    if (0 == (n % 8)) {
+      if ((n % 3) == 0) {
+        addr &= ~uint64_t(PAGE_SIZE - 1);
+        size = (size + PAGE_SIZE - 1) & ~uint64_t(PAGE_SIZE - 1);
+      }
+      acl.set(addr, size, flags);
+      memset(ref.data() + addr, flags ? flags : 0xff, size);
+    } else {
+      bool granted = true;
+      for (uint64_t i = 0; i < size; ++i) {
+        granted &= ((ref[addr + i] & flags) == flags);
+      }
+      failed = (acl.check(addr, size, flags) != granted);
+    }
+  }
+
+  std::cout.rdbuf(cout_buf);
+  CHECK(!failed);
+  return 0;
+}
+
+// word loads/stores as issued by the emulator, with and without ACL checks
+int bench_acl(uint64_t size) {
+  RAM ram(0, PAGE_SIZE);
+  std::vector<uint8_t> src(size, 0x5a);
+  ram.write(src.data(), 0, size);
+
+  // buffers as allocated by the runtime
+  for (uint64_t addr = 0; addr < size; addr += 16 * PAGE_SIZE) {
+    ram.set_acl(addr + 64, 12 * PAGE_SIZE, 0x3);
+    ram.set_acl(addr + 64 + 12 * PAGE_SIZE, 2 * PAGE_SIZE, 0x1);
+  }
+
+  for (int acl = 0; acl < 2; ++acl) {
+    ram.enable_acl(acl != 0);
+    uint64_t sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t addr = 0; addr < size; addr += 16 * PAGE_SIZE) {
+      for (uint64_t i = 64; i < 64 + 12 * PAGE_SIZE; i += 4) {
+        uint32_t value;
+        ram.read(&value, addr + i, 4);
+        sum += value;
+        ram.write(&value, addr + i, 4);
+      }
+    }
+    double ms = elapsed_ms(start);
+    CHECK(sum != 0);
+    uint64_t accesses = 2 * (size / (16 * PAGE_SIZE)) * (3 * PAGE_SIZE);
+    printf("load/store (acl=%d): %.1f M accesses/s\n", acl, accesses / (ms * 1000.0));
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  uint64_t size = 64 * 1024 * 1024;
+  if (argc > 1) {
+    size = strtoull(argv[1], nullptr, 0);
+  }
+
+  if (test_copies())
+    return -1;
+
+  if (test_bounds())
+    return -1;
+
+  if (test_map_file())
+    return -1;
+
+  if (test_snapshot())
+    return -1;
+
+  if (test_acl())
+    return -1;
+
+  if (bench_bandwidth(size))
+    return -1;
+
+  if (bench_acl(size))
+    return -1;
+
+  printf("PASSED!\n");
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include <rvfloats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <random>
+
+#define CHECK(_cond)                                            \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     return -1;                                                 \
+   } while (false)
+
+#define NUM_SAMPLES 200000
+
+static std::mt19937_64 rng(0x5eed);
+
+// random operands biased towards the corner cases of each format:
+// signed zeros, subnormals, extreme exponents, infinities and NaNs.
+template <typename T, uint32_t EXP_BITS, uint32_t MAN_BITS>
+static T gen_value() {
+  T sign = (T)(rng() & 1) << (EXP_BITS + MAN_BITS);
+  T man = (T)rng() & (((T)1 << MAN_BITS) - 1);
+  T exp_max = ((T)1 << EXP_BITS) - 1;
+  T bias = exp_max >> 1;
+  T exp;
+  switch (rng() % 8) {
+  case 0: exp = 0; break;
+  case 1: exp = exp_max; break;
+  case 2: exp = (T)(rng() % 4) + 1; break;
+  case 3: exp = exp_max - 1 - (T)(rng() % 4); break;
+  case 4: man = (rng() & 1) ? 0 : man; exp = (T)rng() % exp_max; break;
+  default: exp = bias + (T)(rng() % 16) - 8; break;
+  }
+  return sign | (exp << MAN_BITS) | man;
+}
+
+template <typename T, typename Op>
+static bool check_op(const char* name, Op op, T (*gen)()) {
+  for (int i = 0; i < NUM_SAMPLES; ++i) {
+    T a = gen(), b = gen(), c = gen();
+    // bias c towards cancelling the product, exercising fused rounding
+    if (rng() & 1) {
+      c = op.negated_product(a, b, c);
+    }
+    uint32_t frm = (rng() & 1) ? 0 : (rng() % 5);
+    uint32_t native_flags = 0, soft_flags = 0;
+    rv_set_native(true);
+    T native_res = op(a, b, c, frm, &native_flags);
+    rv_set_native(false);
+    T soft_res = op(a, b, c, frm, &soft_flags);
+    if (native_res != soft_res || native_flags != soft_flags) {
+      printf("Error: %s(0x%llx, 0x%llx, 0x%llx, frm=%d) native=0x%llx/0x%x softfloat=0x%llx/0x%x\n",
+             name, (unsigned long long)a, (unsigned long long)b, (unsigned long long)c, frm,
+             (unsigned long long)native_res, native_flags,
+             (unsigned long long)soft_res, soft_flags);
+      return false;
+    }
+  }
+  return true;
+}
+
+#define BINARY_OP(_name, _type)                                             \
+  struct _name##_op {                                                       \
+    _type operator()(_type a, _type b, _type, uint32_t frm, uint32_t* f) {  \
+      return rv_##_name(a, b, frm, f);                                      \
+    }                                                                       \
+    _type negated_product(_type, _type, _type c) { return c; }              \
+  }
+
+#define UNARY_OP(_name, _type)                                              \
+  struct _name##_op {                                                       \
+    _type operator()(_type a, _type, _type, uint32_t frm, uint32_t* f) {    \
+      return rv_##_name(a, frm, f);                                         \
+    }                                                                       \
+    _type negated_product(_type, _type, _type c) { return c; }              \
+  }
+
+#define TERNARY_OP(_name, _type, _mul)                                      \
+  struct _name##_op {                                                       \
+    _type operator()(_type a, _type b, _type c, uint32_t frm, uint32_t* f) {\
+      return rv_##_name(a, b, c, frm, f);                                   \
+    }                                                                       \
+    _type negated_product(_type a, _type b, _type) {                        \
+      uint32_t flags;                                                       \
+      return _mul(a, b, 0, &flags) ^ ((_type)1 << (sizeof(_type) * 8 - 1));\
+    }                                                                       \
+  }
+
+BINARY_OP(fadd_s, uint32_t);
+BINARY_OP(fsub_s, uint32_t);
+BINARY_OP(fmul_s, uint32_t);
+BINARY_OP(fdiv_s, uint32_t);
+UNARY_OP(fsqrt_s, uint32_t);
+TERNARY_OP(fmadd_s, uint32_t, rv_fmul_s);
+TERNARY_OP(fmsub_s, uint32_t, rv_fmul_s);
+TERNARY_OP(fnmadd_s, uint32_t, rv_fmul_s);
+TERNARY_OP(fnmsub_s, uint32_t, rv_fmul_s);
+
+BINARY_OP(fadd_d, uint64_t);
+BINARY_OP(fsub_d, uint64_t);
+BINARY_OP(fmul_d, uint64_t);
+BINARY_OP(fdiv_d, uint64_t);
+UNARY_OP(fsqrt_d, uint64_t);
+TERNARY_OP(fmadd_d, uint64_t, rv_fmul_d);
+TERNARY_OP(fmsub_d, uint64_t, rv_fmul_d);
+TERNARY_OP(fnmadd_d, uint64_t, rv_fmul_d);
+TERNARY_OP(fnmsub_d, uint64_t, rv_fmul_d);
+
+int main() {
+  auto gen_s = gen_value<uint32_t, 8, 23>;
+  auto gen_d = gen_value<uint64_t, 11, 52>;
+
+  // the host FPU path must match softfloat bit for bit, flags included
+  CHECK(check_op("fadd_s", fadd_s_op(), gen_s));
+  CHECK(check_op("fsub_s", fsub_s_op(), gen_s));
+  CHECK(check_op("fmul_s", fmul_s_op(), gen_s));
+  CHECK(check_op("fdiv_s", fdiv_s_op(), gen_s));
+  CHECK(check_op("fsqrt_s", fsqrt_s_op(), gen_s));
+  CHECK(check_op("fmadd_s", fmadd_s_op(), gen_s));
+  CHECK(check_op("fmsub_s", fmsub_s_op(), gen_s));
+  CHECK(check_op("fnmadd_s", fnmadd_s_op(), gen_s));
+  CHECK(check_op("fnmsub_s", fnmsub_s_op(), gen_s));
+
+  CHECK(check_op("fadd_d", fadd_d_op(), gen_d));
+  CHECK(check_op("fsub_d", fsub_d_op(), gen_d));
+  CHECK(check_op("fmul_d", fmul_d_op(), gen_d));
+  CHECK(check_op("fdiv_d", fdiv_d_op(), gen_d));
+  CHECK(check_op("fsqrt_d", fsqrt_d_op(), gen_d));
+  CHECK(check_op("fmadd_d", fmadd_d_op(), gen_d));
+  CHECK(check_op("fmsub_d", fmsub_d_op(), gen_d));
+  CHECK(check_op("fnmadd_d", fnmadd_d_op(), gen_d));
+  CHECK(check_op("fnmsub_d", fnmsub_d_op(), gen_d));
+
+  printf("PASSED!\n");
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include <processor.h>
+#include <arch.h>
+#include <mem.h>
+#include <constants.h>
+#include <VX_types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+
+using namespace vortex;
+
+// count the heap allocations made through the C++ allocator while enabled
+static bool counting = false;
+static uint64_t alloc_count = 0;
+
+void* operator new(size_t size) {
+  if (counting)
+    ++alloc_count;
+  auto ptr = malloc(size);
+  if (nullptr == ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+#define CHECK(_cond)                                            \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     return -1;                                                 \
+   } while (false)
+
+static const uint64_t startup_addr = 0x80000000;
+static const uint64_t data_addr = 0x80010000;
+
+enum { T0 = 5, T1 = 6, T2 = 7, GP = 3, A0 = 10, A1 = 11, A2 = 12, A3 = 13 };
+
+static uint32_t rv_itype(uint32_t op, uint32_t f3, uint32_t rd, uint32_t rs1, int32_t imm) {
+  return (uint32_t(imm & 0xfff) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static uint32_t rv_stype(uint32_t op, uint32_t f3, uint32_t rs1, uint32_t rs2, int32_t imm) {
+  return (uint32_t((imm >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (uint32_t(imm & 0x1f) << 7) | op;
+}
+
+static uint32_t rv_rtype(uint32_t op, uint32_t f3, uint32_t f7, uint32_t rd, uint32_t rs1, uint32_t rs2) {
+  return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static uint32_t rv_bne(uint32_t rs1, uint32_t rs2, int32_t offset) {
+  uint32_t imm = uint32_t(offset);
+  return (((imm >> 12) & 0x1) << 31) | (((imm >> 5) & 0x3f) << 25) | (rs2 << 20) | (rs1 << 15)
+       | (1 << 12) | (((imm >> 1) & 0xf) << 8) | (((imm >> 11) & 0x1) << 7) | 0x63;
+}
+
+static uint32_t rv_addi(uint32_t rd, uint32_t rs1, int32_t imm) { return rv_itype(0x13, 0, rd, rs1, imm); }
+static uint32_t rv_slli(uint32_t rd, uint32_t rs1, int32_t shamt) { return rv_itype(0x13, 1, rd, rs1, shamt); }
+static uint32_t rv_add(uint32_t rd, uint32_t rs1, uint32_t rs2) { return rv_rtype(0x33, 0, 0, rd, rs1, rs2); }
+static uint32_t rv_lui(uint32_t rd, uint32_t imm) { return (imm & 0xfffff000) | (rd << 7) | 0x37; }
+static uint32_t rv_auipc(uint32_t rd, uint32_t imm) { return (imm & 0xfffff000) | (rd << 7) | 0x17; }
+static uint32_t rv_lw(uint32_t rd, uint32_t rs1, int32_t imm) { return rv_itype(0x03, 2, rd, rs1, imm); }
+static uint32_t rv_sw(uint32_t rs2, uint32_t rs1, int32_t imm) { return rv_stype(0x23, 2, rs1, rs2, imm); }
+static uint32_t rv_csrr(uint32_t rd, uint32_t csr) { return rv_itype(0x73, 2, rd, 0, csr); }
+static uint32_t rv_ecall() { return 0x73; }
+static uint32_t vx_tmc(uint32_t rs1) { return rv_rtype(0x0b, 0, 0, 0, rs1, 0); }
+static uint32_t vx_bar(uint32_t rs1, uint32_t rs2) { return rv_rtype(0x0b, 4, 0, 0, rs1, rs2); }
+
+// every thread adds up its own word 'count' times and stores the sum:
+// the loop covers the ALU, LSU and SFU paths and stalls on the load-use
+// dependency, its loads hit in the caches so that no DRAM traffic is left.
+static std::vector<uint32_t> make_program(uint32_t count) {
+  std::vector<uint32_t> code;
+  code.push_back(rv_addi(T0, 0, -1));
+  code.push_back(vx_tmc(T0));
+  code.push_back(rv_lui(T1, count + 0x800));
+  code.push_back(rv_addi(T1, T1, int32_t(count << 20) >> 20));
+  code.push_back(rv_addi(T2, 0, 1));
+  // PC-relative, lui would sign-extend the address on RV64
+  code.push_back(rv_auipc(A0, uint32_t(data_addr - startup_addr)));
+  code.push_back(rv_addi(A0, A0, -4 * int32_t(code.size() - 1)));
+  code.push_back(rv_csrr(A2, VX_CSR_THREAD_ID));
+  code.push_back(rv_slli(A2, A2, 2));
+  code.push_back(rv_add(A0, A0, A2));
+  uint32_t loop = code.size();
+  code.push_back(rv_lw(A3, A0, 0));
+  code.push_back(rv_add(A1, A1, A3));
+  code.push_back(vx_bar(0, T2));
+  code.push_back(rv_addi(T1, T1, -1));
+  code.push_back(rv_bne(T1, 0, int32_t(loop - code.size()) * 4));
+  code.push_back(rv_sw(A1, A0, 0));
+  code.push_back(rv_addi(T0, 0, 1));
+  code.push_back(vx_tmc(T0));
+  code.push_back(rv_addi(GP, 0, 1));
+  code.push_back(rv_ecall());
+  return code;
+}
+
+static int run_program(uint32_t count, uint64_t* allocs) {
+  Arch arch(NUM_THREADS, NUM_WARPS, NUM_CORES);
+  RAM ram(0, RAM_PAGE_SIZE);
+  Processor processor(arch);
+  processor.attach_ram(&ram);
+
+  processor.dcr_write(VX_DCR_BASE_STARTUP_ADDR0, startup_addr & 0xffffffff);
+#if (XLEN == 64)
+  processor.dcr_write(VX_DCR_BASE_STARTUP_ADDR1, startup_addr >> 32);
+#endif
+  processor.dcr_write(VX_DCR_BASE_MPM_CLASS, 0);
+
+  auto code = make_program(count);
+  ram.write(code.data(), startup_addr, code.size() * sizeof(uint32_t));
+
+  std::vector<uint32_t> ones(NUM_THREADS, 1);
+  ram.write(ones.data(), data_addr, ones.size() * sizeof(uint32_t));
+
+  alloc_count = 0;
+  counting = true;
+  processor.run();
+  counting = false;
+  *allocs = alloc_count;
+
+  std::vector<uint32_t> values(NUM_THREADS);
+  ram.read(values.data(), data_addr, values.size() * sizeof(uint32_t));
+  for (auto value : values) {
+    CHECK(value == count);
+  }
+
+  return 0;
+}
+
+int main() {
+  const uint32_t count = 1000;
+
+  // a first run populates the process-wide event pools
+  uint64_t warmup_allocs, short_allocs, long_allocs;
+  CHECK(0 == run_program(count, &warmup_allocs));
+
+  // the allocations of a run must not scale with the instructions executed
+  CHECK(0 == run_program(count, &short_allocs));
+  CHECK(0 == run_program(count * 10, &long_allocs));
+
+  printf("heap allocations: %ld (%d iterations), %ld (%d iterations)\n",
+         short_allocs, count, long_allocs, count * 10);
+  CHECK(long_allocs == short_allocs);
+
+  printf("PASSED!\n");
+
+  return 0;
+}